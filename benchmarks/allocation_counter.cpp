@@ -0,0 +1,25 @@
+//
+// Created by Chris Luttio on 1/14/22.
+//
+
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<size_t> allocation_count{0};
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
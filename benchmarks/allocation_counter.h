@@ -0,0 +1,33 @@
+//
+// Created by Chris Luttio on 1/14/22.
+//
+
+#ifndef CHESS_ALLOCATION_COUNTER_H
+#define CHESS_ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "benchmark.h"
+
+/*
+ * Counts every call to the global operator new made by the benchmark binary.
+ */
+extern std::atomic<size_t> allocation_count;
+
+/*
+ * Measures the allocations made while the benchmark loop runs and reports them per iteration.
+ */
+struct AllocationCounter {
+    explicit AllocationCounter(benchmark::State& state): state(state), start(allocation_count.load()) {}
+
+    ~AllocationCounter() {
+        state.counters["allocs_per_call"] = benchmark::Counter((double)(allocation_count.load() - start), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& state;
+    size_t start;
+};
+
+#endif //CHESS_ALLOCATION_COUNTER_H
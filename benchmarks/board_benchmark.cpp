@@ -3,8 +3,10 @@
 //
 
 #include "benchmark.h"
+#include "allocation_counter.h"
 
 #include "pure_states/board.h"
+#include "pure_states/bitbases.h"
 #include "data_types.h"
 
 static void BM_board_init(benchmark::State& state) {
@@ -58,6 +60,7 @@ BENCHMARK(BM_stalemate);
 static void BM_possible_moves_pawn(benchmark::State& state) {
     Board board;
     Board::setup(board);
+    AllocationCounter allocations(state);
     for (auto _: state) {
         auto moves = board.possible_moves({1, 0});
     }
@@ -65,6 +68,35 @@ static void BM_possible_moves_pawn(benchmark::State& state) {
 
 BENCHMARK(BM_possible_moves_pawn);
 
+static void BM_legal_moves(benchmark::State& state) {
+    Board board;
+    Board::setup(board);
+    AllocationCounter allocations(state);
+    for (auto _: state) {
+        auto moves = board.legal_moves(White);
+        benchmark::DoNotOptimize(moves);
+    }
+}
+
+BENCHMARK(BM_legal_moves);
+
+static void BM_legal_moves_middlegame(benchmark::State& state) {
+    Board board;
+    Board::setup(board);
+    for (const auto& [from, to]: std::vector<std::pair<BoardPosition, BoardPosition>>{
+            {{6, 4}, {4, 4}}, {{1, 4}, {3, 4}}, {{7, 6}, {5, 5}}, {{0, 1}, {2, 2}},
+            {{7, 5}, {4, 2}}, {{0, 6}, {2, 5}}, {{6, 3}, {5, 3}}, {{1, 3}, {2, 3}}}) {
+        board.move(board.classify_move({from, to}));
+    }
+    AllocationCounter allocations(state);
+    for (auto _: state) {
+        auto moves = board.legal_moves(White);
+        benchmark::DoNotOptimize(moves);
+    }
+}
+
+BENCHMARK(BM_legal_moves_middlegame);
+
 static void BM_legal_move(benchmark::State& state) {
     Board board;
     Board::setup(board);
@@ -159,3 +191,30 @@ static void BM_get_threatened_positions_queen(benchmark::State& state) {
 
 BENCHMARK(BM_get_threatened_positions_queen);
 
+
+/*
+ * Argument is the ending, in Bitbases::Ending order.
+ */
+static void BM_bitbase_generate(benchmark::State& state) {
+    auto ending = (Bitbases::Ending)state.range(0);
+    for (auto _: state) {
+        Bitbases bitbases;
+        bitbases.generate({ending});
+        benchmark::DoNotOptimize(bitbases.endings[ending].wins.data());
+    }
+}
+
+BENCHMARK(BM_bitbase_generate)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
+
+static void BM_bitbase_probe(benchmark::State& state) {
+    Bitbases bitbases;
+    bitbases.generate({Bitbases::KPK});
+    Board board;
+    Board::load_fen(board, "8/8/5k2/8/8/4K3/6P1/8 w - - 0 1");
+    for (auto _: state) {
+        auto result = bitbases.probe(board);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_bitbase_probe);
@@ -0,0 +1,80 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "benchmark.h"
+
+#include <array>
+#include <memory>
+#include <utility>
+
+#include "pure_states/board.h"
+#include "search/mate_search.h"
+#include "search/search.h"
+#include "scorers/material_scorer.h"
+
+/*
+ * Mate puzzles and how many moves each needs.
+ */
+static const std::array<std::pair<const char*, int>, 6> MATE_PUZZLES{{
+        {"r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4", 1},
+        {"k7/8/2K5/8/8/8/8/7R w - - 0 1", 2},
+        {"r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1", 2},
+        {"1rb4r/pkPp3p/1b1P3n/1Q6/N3Pp2/8/P1P3PP/7K w - - 1 1", 2},
+        {"r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1", 3},
+        {"8/8/8/8/8/2k5/8/1K1Q4 w - - 0 1", 4},
+}};
+
+/*
+ * Argument is 1 to only look at checks. Solves every puzzle, reporting how many were solved in the number of moves they need and the nodes it took.
+ */
+static void BM_mate_search(benchmark::State& state) {
+    std::array<Board, MATE_PUZZLES.size()> boards;
+    for (size_t i = 0; i < MATE_PUZZLES.size(); i++)
+        Board::load_fen(boards[i], MATE_PUZZLES[i].first);
+    MateSearch search;
+    search.checks_only = state.range(0) == 1;
+    int solved = 0;
+    uint64_t nodes = 0;
+    for (auto _: state) {
+        solved = 0;
+        nodes = 0;
+        for (size_t i = 0; i < MATE_PUZZLES.size(); i++) {
+            auto result = search.solve(boards[i], MATE_PUZZLES[i].second);
+            solved += result.proof == Proven && result.moves == MATE_PUZZLES[i].second;
+            nodes += result.nodes;
+        }
+    }
+    state.counters["solved"] = solved;
+    state.counters["nodes"] = (double)nodes;
+}
+
+BENCHMARK(BM_mate_search)->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+/*
+ * The same puzzles with the alpha-beta search, every move to the depth of the mate, for comparison.
+ */
+static void BM_mate_search_alpha_beta(benchmark::State& state) {
+    std::array<Board, MATE_PUZZLES.size()> boards;
+    for (size_t i = 0; i < MATE_PUZZLES.size(); i++)
+        Board::load_fen(boards[i], MATE_PUZZLES[i].first);
+    int solved = 0;
+    uint64_t nodes = 0;
+    for (auto _: state) {
+        solved = 0;
+        nodes = 0;
+        for (size_t i = 0; i < MATE_PUZZLES.size(); i++) {
+            Search search(std::make_shared<MaterialScorer>(), std::make_shared<TranspositionTable>(16));
+            search.options = SearchOptions::full_width();
+            search.options.pawn_value = 1;
+            int plies = 2 * MATE_PUZZLES[i].second - 1;
+            auto result = search.run(boards[i], plies);
+            solved += result.score == Search::MATE_SCORE - plies;
+            nodes += result.stats.nodes;
+        }
+    }
+    state.counters["solved"] = solved;
+    state.counters["nodes"] = (double)nodes;
+}
+
+BENCHMARK(BM_mate_search_alpha_beta)->Unit(benchmark::kMillisecond);
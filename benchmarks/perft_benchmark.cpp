@@ -0,0 +1,60 @@
+//
+// Created by Chris Luttio on 1/14/22.
+//
+
+#include "benchmark.h"
+
+#include "pure_states/perft.h"
+
+/*
+ * Arguments are the index into perft_positions and the depth.
+ */
+static void BM_perft(benchmark::State& state) {
+    const auto& position = perft_positions[state.range(0)];
+    int depth = (int)state.range(1);
+    Board board;
+    Board::load_fen(board, position.fen);
+    state.SetLabel(position.name);
+    uint64_t nodes = 0;
+    for (auto _: state) {
+        nodes = perft(board, depth);
+        benchmark::DoNotOptimize(nodes);
+    }
+    if (nodes != position.nodes[depth - 1])
+        state.SkipWithError("node count differs from the reference");
+    state.counters["nodes"] = (double)nodes;
+    state.counters["nps"] = benchmark::Counter((double)nodes, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(BM_perft)
+    ->ArgsProduct({{0, 1, 2, 3, 4, 5}, {3, 4}})
+    ->Unit(benchmark::kMillisecond);
+
+/*
+ * Arguments are the index into perft_positions, the depth and the number of threads.
+ * Each iteration starts from an empty table so the counts aren't just read back from the last one.
+ */
+static void BM_perft_parallel(benchmark::State& state) {
+    const auto& position = perft_positions[state.range(0)];
+    int depth = (int)state.range(1);
+    int threads = (int)state.range(2);
+    Board board;
+    Board::load_fen(board, position.fen);
+    state.SetLabel(position.name);
+    uint64_t nodes = 0;
+    for (auto _: state) {
+        state.PauseTiming();
+        PerftTable table(64);
+        state.ResumeTiming();
+        nodes = perft_parallel(board, depth, threads, table);
+        benchmark::DoNotOptimize(nodes);
+    }
+    if (nodes != position.nodes[depth - 1])
+        state.SkipWithError("node count differs from the reference");
+    state.counters["nps"] = benchmark::Counter((double)nodes, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(BM_perft_parallel)
+    ->ArgsProduct({{0, 1}, {5}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
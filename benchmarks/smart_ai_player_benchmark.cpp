@@ -3,10 +3,18 @@
 //
 
 #include "benchmark.h"
+#include "allocation_counter.h"
+
+#include <cmath>
+#include <filesystem>
 
 #include "data_types.h"
 #include "pure_states/board.h"
 #include "players/smart_ai_player.h"
+#include "search/opening_book.h"
+#include "scorers/control_scorer.h"
+#include "scorers/material_scorer.h"
+#include "scorers/piece_square_scorer.h"
 
 static void BM_smart_ai_move(benchmark::State& state) {
     Board board;
@@ -14,13 +22,42 @@ static void BM_smart_ai_move(benchmark::State& state) {
     Move king_pawn_move{{6, 4}, {4, 4}};
     king_pawn_move = board.classify_move(king_pawn_move);
     board.move(king_pawn_move);
+    SmartAIPlayer player(Black, (int)state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _: state) {
+        state.PauseTiming();
+        player.table->clear();
+        state.ResumeTiming();
+        Move m = player.move(board);
+    }
+}
+
+BENCHMARK(BM_smart_ai_move)->DenseRange(1, 4)->Unit(benchmark::kMillisecond);
+
+/*
+ * A move from the opening book, against BM_smart_ai_move's search of the same position.
+ */
+static void BM_smart_ai_book_move(benchmark::State& state) {
+    Board board;
+    Board::setup(board);
+    Move king_pawn_move{{6, 4}, {4, 4}};
+    king_pawn_move = board.classify_move(king_pawn_move);
+    board.move(king_pawn_move);
+    Move reply{{1, 2}, {3, 2}};
+    reply = board.classify_move(reply);
+    auto path = (std::filesystem::temp_directory_path() / "bm_smart_ai_book_move.bin").string();
+    OpeningBook::write(path, {{OpeningBook::key(board), OpeningBook::encode(reply), 1, 0}});
     SmartAIPlayer player(Black);
+    player.book = std::make_shared<OpeningBook>();
+    player.book->open(path);
     for (auto _: state) {
         Move m = player.move(board);
+        benchmark::DoNotOptimize(m);
     }
+    std::filesystem::remove(path);
 }
 
-BENCHMARK(BM_smart_ai_move);
+BENCHMARK(BM_smart_ai_book_move)->Unit(benchmark::kMicrosecond);
 
 static void BM_smart_ai_score_position(benchmark::State& state) {
     Board board;
@@ -30,8 +67,134 @@ static void BM_smart_ai_score_position(benchmark::State& state) {
 //    board.move(king_pawn_move);
     SmartAIPlayer player(Black);
     for (auto _: state) {
-        int score = player.score_position(board);
+        int score = player.scorer->score(board, Black);
+    }
+}
+
+BENCHMARK(BM_smart_ai_score_position);
+/*
+ * Argument is the depth. Reports the nodes searched, how often a cutoff came from the first move tried,
+ * how often a zero window or aspiration window search had to be repeated, and how often the table had the position.
+ */
+static void BM_search(benchmark::State& state) {
+    Board board;
+    Board::load_fen(board, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    SmartAIPlayer player(White);
+    SearchResult result;
+    for (auto _: state) {
+        state.PauseTiming();
+        player.table->clear();
+        state.ResumeTiming();
+        Search search(player.scorer, player.table);
+        result = search.run(board, (int)state.range(0));
+    }
+    state.counters["nodes"] = (double)result.stats.nodes;
+    state.counters["first_move_cutoffs"] = result.stats.first_move_cutoff_rate();
+    state.counters["pvs_re_searches"] = (double)result.stats.pvs_re_searches;
+    state.counters["aspiration_re_searches"] = (double)result.stats.aspiration_re_searches;
+    state.counters["table_hits"] = result.stats.table_hit_rate();
+    state.counters["branching"] = result.branching_factor();
+}
+
+BENCHMARK(BM_search)->DenseRange(1, 5)->Unit(benchmark::kMillisecond);
+
+/*
+ * Argument is which selective technique to turn off, -1 for none and 6 for all of them, at depth 5.
+ * Reports the nodes searched, the effective branching factor and how often each technique fired.
+ */
+static void BM_selectivity(benchmark::State& state) {
+    Board board;
+    Board::load_fen(board, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    SmartAIPlayer player(White);
+    SearchOptions options;
+    bool* techniques[] = {&options.null_move, &options.null_move_verification, &options.late_move_reductions,
+                          &options.futility_pruning, &options.razoring, &options.check_extensions};
+    if (state.range(0) == 6)
+        options = SearchOptions::full_width();
+    else if (state.range(0) >= 0)
+        *techniques[state.range(0)] = false;
+    const int depth = 5;
+    SearchResult result;
+    for (auto _: state) {
+        state.PauseTiming();
+        player.table->clear();
+        state.ResumeTiming();
+        Search search(player.scorer, player.table);
+        search.options = options;
+        result = search.run(board, depth);
+    }
+    state.counters["nodes"] = (double)result.stats.nodes;
+    state.counters["branching"] = std::pow((double)result.stats.nodes, 1.0 / depth);
+    state.counters["null_cutoffs"] = (double)result.stats.null_move_cutoffs;
+    state.counters["verify_fails"] = (double)result.stats.null_move_verification_failures;
+    state.counters["reductions"] = (double)result.stats.reductions;
+    state.counters["re_searches"] = (double)result.stats.reduction_re_searches;
+    state.counters["futility"] = (double)result.stats.futility_prunes;
+    state.counters["razor"] = (double)result.stats.razor_prunes;
+    state.counters["extensions"] = (double)result.stats.check_extensions;
+}
+
+BENCHMARK(BM_selectivity)->DenseRange(-1, 6)->Unit(benchmark::kMillisecond);
+
+/*
+ * Argument is the number of threads. Time to reach depth 4 with Lazy SMP, in wall time since the helpers run alongside.
+ */
+static void BM_lazy_smp(benchmark::State& state) {
+    Board board;
+    Board::load_fen(board, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    SmartAIPlayer player(White, 4);
+    player.threads = (int)state.range(0);
+    SearchResult result;
+    for (auto _: state) {
+        state.PauseTiming();
+        player.table->clear();
+        state.ResumeTiming();
+        result = player.search(board);
+    }
+    state.counters["nodes"] = (double)result.stats.nodes;
+}
+
+BENCHMARK(BM_lazy_smp)->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_control_scorer(benchmark::State& state) {
+    Board board;
+    Board::load_fen(board, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    ControlScorer scorer;
+    AllocationCounter allocations(state);
+    for (auto _: state) {
+        int score = scorer.score(board, White);
+        benchmark::DoNotOptimize(score);
+    }
+}
+
+BENCHMARK(BM_control_scorer);
+
+/*
+ * Material and piece-square scores read the totals Board keeps, so they shouldn't depend on how many pieces are left.
+ * Making and unmaking a capture shows what keeping the totals adds to each move.
+ */
+static void BM_material_and_piece_square_scorers(benchmark::State& state) {
+    Board board;
+    Board::load_fen(board, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    MaterialScorer material;
+    PieceSquareScorer piece_square;
+    for (auto _: state) {
+        int score = 10 * material.score(board, White) + piece_square.score(board, White);
+        benchmark::DoNotOptimize(score);
+    }
+}
+
+BENCHMARK(BM_material_and_piece_square_scorers);
+
+static void BM_make_unmake_capture(benchmark::State& state) {
+    Board board;
+    Board::load_fen(board, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    auto capture = board.classify_move({{3, 4}, {1, 5}});
+    for (auto _: state) {
+        auto undo = board.make_move(capture);
+        board.unmake_move(undo);
+        benchmark::DoNotOptimize(board.totals);
     }
 }
 
-BENCHMARK(BM_smart_ai_score_position);
\ No newline at end of file
+BENCHMARK(BM_make_unmake_capture);
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 
@@ -97,6 +98,28 @@ int main() {
     board_entity->set(board);
 
     auto computer_player = std::make_shared<SmartAIPlayer>(Black);
+    computer_player->threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    // There's no game clock, so the computer plays every move as if it had a minute left.
+    computer_player->time_left = std::chrono::minutes(1);
+    computer_player->mate_search_moves = 5;
+    auto book = std::make_shared<OpeningBook>();
+    if (book->open("resources/books/book.bin"))
+        computer_player->book = book;
+    else
+        std::cerr << "Error: book.bin not loaded.\n";
+    // Generated on the first run (or by the endgame_bitbases target) and read back after that.
+    auto bitbases = std::make_shared<Bitbases>();
+    if (!bitbases->load("resources/bitbases"))
+        std::cerr << "Error: bitbases not saved.\n";
+    computer_player->bitbases = bitbases;
+    // CHESS_TELEMETRY names a file to append a line of JSON to for every move the computer searches.
+    if (const char* telemetry_path = std::getenv("CHESS_TELEMETRY")) {
+        auto telemetry = std::make_shared<TelemetryLog>();
+        if (telemetry->open(telemetry_path))
+            computer_player->telemetry = telemetry;
+        else
+            std::cerr << "Error: can't open " << telemetry_path << ".\n";
+    }
     auto threaded_player = AutonomousPlayer(computer_player);
 
     auto receiver = std::make_shared<MultiReceiver>();
@@ -127,6 +150,8 @@ int main() {
                 case sf::Event::KeyReleased: {
                     if (event.key.code == Keyboard::F) {
                         board_entity->set_orientation(board_entity->state->orientation == White ? Black : White);
+                    } else if (event.key.code == Keyboard::Space) {
+                        threaded_player.stop();
                     }
                     break;
                 }
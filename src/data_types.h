@@ -6,6 +6,9 @@
 #define CHESS_DATA_TYPES_H
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <vector>
 
 enum Pieces {
@@ -27,7 +30,7 @@ enum Side {
 struct BoardPosition {
     int row, column;
 
-    [[nodiscard]] bool logical() const {
+    [[nodiscard]] constexpr bool logical() const {
         return row >= 0 && row < 8 && column >= 0 && column < 8;
     }
 
@@ -119,4 +122,133 @@ struct Move {
     }
 };
 
+/*
+ * A move squeezed into 16 bits for search tables and storage: 6 bits for each square and 4 bits of flags.
+ * The flags hold the move type, and for promotions the piece the pawn becomes.
+ * The piece id and type aren't stored since the board knows them, Board::unpack_move puts them back.
+ */
+struct PackedMove {
+    PackedMove() = default;
+
+    explicit PackedMove(const Move& move): data(static_cast<uint16_t>(
+            square(move.current) | (square(move.next) << 6) | (flags(move) << 12))) {}
+
+    [[nodiscard]] BoardPosition from() const {
+        return {(data & 63) / 8, (data & 63) % 8};
+    }
+
+    [[nodiscard]] BoardPosition to() const {
+        return {((data >> 6) & 63) / 8, ((data >> 6) & 63) % 8};
+    }
+
+    [[nodiscard]] move_type type() const {
+        int flag = data >> 12;
+        if (flag >= promotion_flag)
+            return Pawn_Promotion;
+        return static_cast<move_type>(flag < Pawn_Promotion ? flag : flag + 1);
+    }
+
+    [[nodiscard]] Pieces promotion() const {
+        int flag = data >> 12;
+        return flag >= promotion_flag ? static_cast<Pieces>(Rook + flag - promotion_flag) : Queen;
+    }
+
+    /*
+     * Everything but the piece id and type, which are left at their defaults.
+     */
+    [[nodiscard]] Move unpack() const {
+        Move move(from(), to(), type());
+        move.promotion = promotion();
+        return move;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return data == 0;
+    }
+
+    bool operator==(PackedMove other) const {
+        return data == other.data;
+    }
+
+    bool operator!=(PackedMove other) const {
+        return data != other.data;
+    }
+
+    uint16_t data{0};
+
+private:
+    /*
+     * The twelve move types other than Pawn_Promotion take flags 0 to 11, promotions to a rook, bishop, knight or queen take 12 to 15.
+     */
+    static const int promotion_flag = 12;
+
+    static int square(BoardPosition position) {
+        return position.row * 8 + position.column;
+    }
+
+    static int flags(const Move& move) {
+        if (move.type == Pawn_Promotion)
+            return promotion_flag + move.promotion - Rook;
+        return move.type < Pawn_Promotion ? move.type : move.type - 1;
+    }
+};
+
+static_assert(sizeof(PackedMove) == 2);
+
+/*
+ * A list of moves that lives on the stack, so generating moves doesn't touch the heap.
+ * No position has more than 218 legal moves.
+ */
+struct MoveList {
+    static const size_t capacity = 256;
+
+    void push_back(const Move& move) {
+        moves[count++] = move;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return count == 0;
+    }
+
+    Move& operator[](size_t i) {
+        return moves[i];
+    }
+
+    const Move& operator[](size_t i) const {
+        return moves[i];
+    }
+
+    Move* begin() {
+        return moves.data();
+    }
+
+    Move* end() {
+        return moves.data() + count;
+    }
+
+    [[nodiscard]] const Move* begin() const {
+        return moves.data();
+    }
+
+    [[nodiscard]] const Move* end() const {
+        return moves.data() + count;
+    }
+
+    [[nodiscard]] const Move& front() const {
+        return moves[0];
+    }
+
+private:
+    std::array<Move, capacity> moves;
+    size_t count = 0;
+};
+
 #endif //CHESS_DATA_TYPES_H
@@ -5,12 +5,22 @@
 #ifndef CHESS_AUTONOMOUS_PLAYER_H
 #define CHESS_AUTONOMOUS_PLAYER_H
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <iostream>
 
 #include "player.h"
 
+/*
+ * Runs a player on its own thread so the game keeps drawing while it thinks.
+ * The lock is only held to hand the board over and the move back, never while the player is thinking.
+ *
+ * With ponder set, once it has moved it goes on thinking about the position after the reply it expects, on the opponent's time.
+ * If that reply is played the search carries on where it got to instead of starting over, otherwise it is dropped for a new one.
+ */
 struct AutonomousPlayer {
     explicit AutonomousPlayer(std::shared_ptr<Player> player): player(std::move(player)), running{false}, done{false}, alive{true} {
         main = std::thread(&AutonomousPlayer::run, this);
@@ -19,10 +29,31 @@ struct AutonomousPlayer {
     void start(const Board& b) {
         auto lock = std::unique_lock<std::mutex>(mtx);
         board = b;
+        if (pondering) {
+            ponder_hit = b.key == ponder_board.key;
+            cancel = !ponder_hit;
+            pondering = false;
+        } else {
+            cancel = false;
+        }
         running = true;
         cv.notify_one();
     }
 
+    /*
+     * Asks the player to move now, it finishes with the best move it has found so far.
+     * Stopping while pondering drops the ponder search, it was cut short so even the expected reply gets a new search.
+     */
+    void stop() {
+        auto lock = std::unique_lock<std::mutex>(mtx);
+        cancel = true;
+        if (pondering) {
+            ponder_hit = false;
+            pondering = false;
+            cv.notify_one();
+        }
+    }
+
     [[nodiscard]] Move get_move() {
         auto lock = std::unique_lock<std::mutex>(mtx);
         done = false;
@@ -37,34 +68,90 @@ struct AutonomousPlayer {
         return done;
     }
 
+    [[nodiscard]] bool is_pondering() const {
+        return pondering;
+    }
+
+    /*
+     * Set before the first start.
+     */
+    bool ponder{true};
+
     ~AutonomousPlayer() {
-        alive = false;
+        {
+            auto lock = std::unique_lock<std::mutex>(mtx);
+            alive = false;
+        }
+        cancel = true;
         cv.notify_one();
         main.join();
     }
 
 private:
     void run() {
-        while (alive) {
-            auto lock = std::unique_lock<std::mutex>(mtx);
-            while (!running) {
-                if (!alive)
-                    return;
-                cv.wait(lock);
+        auto lock = std::unique_lock<std::mutex>(mtx);
+        while (true) {
+            cv.wait(lock, [this]() { return running || !alive; });
+            if (!alive)
+                return;
+            Board position = board;
+            lock.unlock();
+            Move result = player->move(position, cancel);
+            lock.lock();
+            while (finish(position, result, lock)) {
+                // The expected reply was played and the ponder search has become the search for the next move.
+                position = ponder_board;
+                result = ponder_move;
             }
-            move = player->move(board);
-            running = false;
-            done = true;
         }
     }
 
+    /*
+     * Hands the move back, then ponders until the opponent's move comes in. Returns whether it was the expected one.
+     */
+    bool finish(const Board& position, const Move& result, std::unique_lock<std::mutex>& lock) {
+        move = result;
+        running = false;
+        done = true;
+        if (!ponder || !alive || PackedMove(result).empty())
+            return false;
+
+        Board expected = position;
+        expected.make_move(result);
+        Move reply = player->expected_reply(expected);
+        if (PackedMove(reply).empty())
+            return false;
+        expected.make_move(reply);
+
+        ponder_board = expected;
+        ponder_hit = false;
+        // A stop before this was for the search that just finished.
+        cancel = false;
+        pondering = true;
+        lock.unlock();
+        Move pondered = player->ponder(expected, cancel, pondering);
+        lock.lock();
+        // The search can run out of moves to look at before the reply comes in.
+        cv.wait(lock, [this]() { return !pondering || !alive; });
+        pondering = false;
+        if (!alive || !ponder_hit) {
+            cancel = false;
+            return false;
+        }
+        ponder_move = pondered;
+        return true;
+    }
+
     Board board;
     Move move;
+    Board ponder_board;
+    Move ponder_move;
+    bool ponder_hit{false};
     std::thread main;
     std::shared_ptr<Player> player;
     std::condition_variable cv;
     std::mutex mtx;
-    bool running, done, alive;
+    std::atomic<bool> running, done, alive, cancel{false}, pondering{false};
 };
 
 #endif //CHESS_AUTONOMOUS_PLAYER_H
@@ -5,11 +5,35 @@
 #ifndef CHESS_PLAYER_H
 #define CHESS_PLAYER_H
 
+#include <atomic>
+
 #include "../data_types.h"
 #include "../pure_states/board.h"
 
 struct Player {
     [[nodiscard]] virtual Move move(const Board&) const = 0;
+
+    /*
+     * Players that take a while should return the best move they have found as soon as stop is set.
+     */
+    [[nodiscard]] virtual Move move(const Board& board, const std::atomic<bool>& /*stop*/) const {
+        return move(board);
+    }
+
+    /*
+     * The reply the player expects after its own move on board, or an empty move if it doesn't expect any in particular.
+     */
+    [[nodiscard]] virtual Move expected_reply(const Board& /*board*/) const {
+        return {};
+    }
+
+    /*
+     * Thinks about board, the position after the expected reply, on the opponent's time while pondering is set.
+     * Clearing pondering means the reply was played, and it carries on as move would from there.
+     */
+    [[nodiscard]] virtual Move ponder(const Board& board, const std::atomic<bool>& stop, const std::atomic<bool>& /*pondering*/) const {
+        return move(board, stop);
+    }
 };
 
 #endif //CHESS_PLAYER_H
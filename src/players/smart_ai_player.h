@@ -7,36 +7,184 @@
 
 #include "player.h"
 
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <thread>
 #include <vector>
-#include <list>
 #include <utils.h>
-#include <queue>
 
 #include "scorers/scorer.h"
 #include "scorers/aggregate_scorer.h"
 #include "scorers/material_scorer.h"
 #include "scorers/development_scorer.h"
-#include "scorers/control_scorer.h"
 #include "scorers/center_scorer.h"
-#include "scorers/checkmate_scorer.h"
+#include "scorers/piece_square_scorer.h"
+#include "scorers/timed_scorer.h"
+#include "search/mate_search.h"
+#include "search/opening_book.h"
+#include "search/search.h"
+#include "search/telemetry.h"
+#include "search/time_manager.h"
+#include "search/transposition_table.h"
 
 struct SmartAIPlayer: Player {
-    static const int LOWEST_SCORE = -2147483648;
-    static const int HIGHEST_SCORE = 2147483647;
-
-    explicit SmartAIPlayer(Side color): color(color) {
+    explicit SmartAIPlayer(Side color, int depth = 4, size_t table_megabytes = 16):
+        color(color), depth(depth), table(std::make_shared<TranspositionTable>(table_megabytes)) {
+        timed_scorers = {
+                std::make_shared<TimedScorer>("center", std::make_shared<AccurateCenterScorer>()),
+                std::make_shared<TimedScorer>("development", std::make_shared<DevelopmentScorer>()),
+                std::make_shared<TimedScorer>("material", std::make_shared<MaterialScorer>()),
+                std::make_shared<TimedScorer>("piece_square", std::make_shared<PieceSquareScorer>()),
+        };
         auto aggregate = std::make_shared<AggregateScorer>();
-        aggregate->push_back(1, std::make_shared<AccurateCenterScorer>());
-        aggregate->push_back(3, std::make_shared<ControlScorer>());
-        aggregate->push_back(1, std::make_shared<DevelopmentScorer>());
-//        aggregate->push_back(1, std::make_shared<MaterialScorer>());
-        aggregate->push_back(1, std::make_shared<CheckmateScorer>());
+        aggregate->push_back(1, timed_scorers[0]);
+        aggregate->push_back(1, timed_scorers[1]);
+        aggregate->push_back(10, timed_scorers[2]);
+        aggregate->push_back(1, timed_scorers[3]);
         scorer = aggregate;
     }
 
     [[nodiscard]] Move move(const Board& board) const override {
-        return find_best_score(board, color, 0).second;
+        if (auto move = book_move(board))
+            return *move;
+        return search(board).move;
+    }
+
+    [[nodiscard]] Move move(const Board& board, const std::atomic<bool>& stop) const override {
+        if (auto move = book_move(board))
+            return *move;
+        return search(board, &stop).move;
+    }
+
+    [[nodiscard]] std::optional<Move> book_move(const Board& board) const {
+        if (!book)
+            return std::nullopt;
+        return book->pick(board, (uint32_t)rand());
+    }
+
+    /*
+     * The best reply the search found, if it is still in the table.
+     */
+    [[nodiscard]] Move expected_reply(const Board& board) const override {
+        TranspositionEntry entry;
+        if (!table->probe(board.key, entry) || entry.move.empty())
+            return {};
+        Move reply = board.unpack_move(entry.move);
+        return board.legal(reply) ? reply : Move();
+    }
+
+    [[nodiscard]] Move ponder(const Board& board, const std::atomic<bool>& stop, const std::atomic<bool>& pondering) const override {
+        return search(board, &stop, &pondering).move;
+    }
+
+    /*
+     * Lazy SMP: with more than one thread, helper threads search the same position alongside the main one, sharing the table.
+     * Half of them skip the first iteration so they are a ply ahead of the others, and each one's move ordering soon differs,
+     * so they fill the table with different parts of the tree which the main search then finds instead of searching.
+     * The main thread's result is the one used, the helpers are stopped once it is done.
+     * The node limit is shared, the threads together search about as many nodes as one would.
+     *
+     * With time left on the clock the time manager decides how deep to go, otherwise the search goes to the set depth.
+     *
+     * When the other king is exposed, a mate search runs on a thread of its own as well, and its mate is played if the search didn't find one as short.
+     * On the clock it is stopped when the search is done, otherwise it runs until it proves or disproves a mate, runs out of nodes or is cancelled.
+     *
+     * When timing the scorers, the result has the time each took. It is written to the telemetry log if there is one, timing them too.
+     */
+    [[nodiscard]] SearchResult search(const Board& board, const std::atomic<bool>* cancel = nullptr, const std::atomic<bool>* pondering = nullptr) const {
+        SearchLimits limits;
+        limits.stop = cancel;
+        limits.ponder = pondering;
+        limits.nodes = nodes;
+        std::atomic<uint64_t> searched{0};
+        limits.shared_nodes = &searched;
+        std::optional<TimeManager> time;
+        if (time_left.count() > 0) {
+            time.emplace(time_left, increment);
+            limits.time = &*time;
+        } else {
+            limits.depth = depth;
+        }
+
+        bool timing = time_scorers || telemetry;
+        for (const auto& timed: timed_scorers)
+            timed->timing = timing;
+        std::vector<ScorerTime> scorer_times_before = scorer_times();
+        table->new_search();
+        std::atomic<bool> stop{false};
+        std::atomic<bool> stop_mate{false};
+        MateResult mate;
+        std::thread mate_search;
+        if (mate_search_moves > 0 && MateSearch::king_exposed(board)) {
+            // Off the clock it watches cancel itself, so a stop while waiting for it still ends it.
+            const std::atomic<bool>* mate_stop = time ? &stop_mate : cancel;
+            mate_search = std::thread([&, mate_stop]() {
+                MateSearch solver;
+                mate = solver.solve(board, mate_search_moves, mate_stop);
+            });
+        }
+        std::vector<std::thread> helpers;
+        std::vector<SearchStats> helper_stats(std::max(threads, 1) - 1);
+        for (int i = 1; i < threads; i++) {
+            helpers.emplace_back([&, i]() {
+                SearchLimits helper_limits;
+                helper_limits.stop = &stop;
+                helper_limits.nodes = limits.nodes;
+                helper_limits.shared_nodes = &searched;
+                Search helper(scorer, table);
+                helper.options = options;
+                helper.bitbases = bitbases;
+                helper_stats[i - 1] = helper.run(board, helper_limits, 1 + i % 2).stats;
+            });
+        }
+
+        Search main(scorer, table);
+        main.options = options;
+        main.bitbases = bitbases;
+        auto result = main.run(board, limits);
+        stop = true;
+        for (auto& helper: helpers)
+            helper.join();
+        for (const auto& stats: helper_stats) {
+            result.stats.nodes += stats.nodes;
+            result.stats.qnodes += stats.qnodes;
+        }
+        if (mate_search.joinable()) {
+            if (time)
+                stop_mate = true;
+            mate_search.join();
+            int mate_score = Search::MATE_SCORE - (2 * mate.moves - 1);
+            if (mate.proof == Proven && result.score < mate_score) {
+                result.move = mate.line.front();
+                result.score = mate_score;
+                result.pv = mate.line;
+                result.lines = {{mate_score, mate.line}};
+            }
+        }
+        if (timing) {
+            result.scorer_times = scorer_times();
+            for (size_t i = 0; i < result.scorer_times.size(); i++) {
+                result.scorer_times[i].calls -= scorer_times_before[i].calls;
+                result.scorer_times[i].time -= scorer_times_before[i].time;
+            }
+        }
+        if (telemetry)
+            telemetry->write(result);
+        return result;
+    }
+
+    /*
+     * How long each scorer has taken in the searches that timed them.
+     */
+    [[nodiscard]] std::vector<ScorerTime> scorer_times() const {
+        std::vector<ScorerTime> times;
+        for (const auto& timed: timed_scorers)
+            times.push_back({timed->name, timed->calls.load(), std::chrono::nanoseconds(timed->nanoseconds.load())});
+        return times;
     }
 
     [[nodiscard]] static Side other_side(Side side) {
@@ -44,91 +192,65 @@ struct SmartAIPlayer: Player {
     }
 
     Side color;
-    std::shared_ptr<Scorer> scorer;
-private:
 
-//    [[nodiscard]] Move find_best(const Board& board, Side side, int depth) const {
-//        auto compare = [](const std::pair<int, Move>& a, const std::pair<int, Move>& b) {
-//            return a.first < b.first;
-//        };
-//
-//        std::priority_queue<std::pair<int, Move>, std::vector<std::pair<int, Move>>, decltype(compare)> priority(compare);
-//
-//        auto pieces = board.get_pieces(side);
-//        for (const auto& piece: pieces) {
-//            auto moves = board.possible_moves(piece);
-//            for (const auto& move: moves) {
-//                auto next = board;
-//                auto mv = next.classify_move(move);
-//                next.move(mv);
-//                int score = scorer->score(next, color) ;
-//                priority.push({score, mv});
-//            }
-//        }
-//
-//        std::vector<Move> best_moves;
-//        best_moves.reserve(10);
-//        for (int i = 0; i < 10; i++) {
-//            best_moves.push_back(priority.top().second);
-//            priority.pop();
-//        }
-//
-//        for (const auto& move: best_moves) {
-//            auto next = board;
-//            auto mv = next.classify_move(move);
-//            next.move(mv);
-//
-//        }
-//    }
+    /*
+     * How many plies ahead to search.
+     */
+    int depth;
 
-    [[nodiscard]] std::pair<int, Move> find_best_score(const Board& board, Side side, int depth) const {
-        if (depth >= 1)
-            return {0, Move{}};
+    /*
+     * How many threads search each move.
+     */
+    int threads = 1;
 
-        auto compare = [](const std::pair<int, Move>& a, const std::pair<int, Move>& b) {
-            return a.first < b.first;
-        };
+    /*
+     * How many nodes to search each move, across all the threads, 0 for no limit.
+     */
+    uint64_t nodes = 0;
 
-        const int num = 0;
+    /*
+     * The player's clock. When there is time left, it is used instead of the depth.
+     */
+    std::chrono::milliseconds time_left{0};
+    std::chrono::milliseconds increment{0};
 
-        std::priority_queue<std::pair<int, Move>, std::vector<std::pair<int, Move>>, decltype(compare)> priority(compare);
+    /*
+     * The selective search techniques to use. The margins are set for the scorer, where a pawn is worth 10.
+     */
+    SearchOptions options;
+    std::shared_ptr<Scorer> scorer;
 
-        auto pieces = board.get_pieces(side);
-        for (const auto& piece: pieces) {
-            auto moves = board.possible_moves(piece);
-            for (const auto& move: moves) {
-                auto next = board;
-                auto mv = next.classify_move(move);
-                next.move(mv);
-                int score = scorer->score(next, color) ;
-                priority.push({score, mv});
-            }
-        }
+    /*
+     * The scorers the aggregate scorer is made of, each timed. Replacing scorer leaves them unused.
+     */
+    std::vector<std::shared_ptr<TimedScorer>> timed_scorers;
+    bool time_scorers = false;
 
-        std::vector<std::pair<int, Move>> best_moves;
-        best_moves.reserve(num);
-        for (int i = 0; i < num || !priority.empty(); i++) {
-            best_moves.push_back(priority.top());
-            priority.pop();
-        }
+    /*
+     * Every search is written to it as a line of JSON when set.
+     */
+    std::shared_ptr<TelemetryLog> telemetry;
 
-        int best_score = -100000000;
-        Move best_move;
-
-        for (auto& pair: best_moves) {
-            auto next = board;
-            auto mv = next.classify_move(pair.second);
-            next.move(mv);
-            int score = find_best_score(next, other_side(side), depth + 1).first;
-            pair.first += score;
-            if (pair.first > best_score) {
-                best_score = pair.first;
-                best_move = pair.second;
-            }
-        }
+    /*
+     * Played from without searching while the position is in it.
+     */
+    std::shared_ptr<OpeningBook> book;
 
-        return {best_score, best_move};
-    }
+    /*
+     * How many moves deep the mate search looks when the other king is exposed, 0 to not look.
+     */
+    int mate_search_moves = 0;
+
+    /*
+     * Win or draw for endings with a lone king, probed by the search.
+     */
+    std::shared_ptr<const Bitbases> bitbases;
+
+    /*
+     * Search results by Zobrist key, kept between moves.
+     * It can be handed to other players to share.
+     */
+    std::shared_ptr<TranspositionTable> table;
 };
 
 #endif //CHESS_SMART_AI_PLAYER_H
@@ -0,0 +1,421 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "bitbases.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+Bitbase::Bitbase(std::vector<Pieces> pieces): pieces(std::move(pieces)) {}
+
+namespace {
+    /*
+     * A position as the squares of the strong king, the weak king and then the pieces, in the bitbase's order.
+     */
+    struct Placement {
+        bool strong_to_move;
+        std::array<int, 4> squares;
+    };
+
+    Bitboard piece_attacks(Pieces type, int square, Bitboard occupied) {
+        switch (type) {
+            case Pawn: return pawn_attacks[White][square];
+            case Knight: return knight_attacks[square];
+            case Bishop: return bishop_attacks(square, occupied);
+            case Rook: return rook_attacks(square, occupied);
+            case Queen: return queen_attacks(square, occupied);
+            default: return 0;
+        }
+    }
+
+    struct Generator {
+        explicit Generator(const std::vector<Pieces>& pieces):
+            pieces(pieces), units(2 + (int)pieces.size()), half((size_t)1 << (6 * units)) {}
+
+        [[nodiscard]] size_t index(const Placement& placement) const {
+            size_t index = placement.strong_to_move ? 0 : 1;
+            for (int i = 0; i < units; i++)
+                index = index * 64 + placement.squares[i];
+            return index;
+        }
+
+        [[nodiscard]] Placement placement(size_t index) const {
+            Placement placement{};
+            for (int i = units - 1; i >= 0; i--) {
+                placement.squares[i] = (int)(index % 64);
+                index /= 64;
+            }
+            placement.strong_to_move = index == 0;
+            return placement;
+        }
+
+        [[nodiscard]] Bitboard occupied(const Placement& placement) const {
+            Bitboard occupied = 0;
+            for (int i = 0; i < units; i++)
+                occupied |= square_bit(placement.squares[i]);
+            return occupied;
+        }
+
+        /*
+         * Every unit on its own square, the kings apart and no pawn on the first or last rank.
+         */
+        [[nodiscard]] bool placed(const Placement& placement) const {
+            if (count_squares(occupied(placement)) != units)
+                return false;
+            if (king_attacks[placement.squares[0]] & square_bit(placement.squares[1]))
+                return false;
+            for (int i = 2; i < units; i++) {
+                int row = placement.squares[i] / 8;
+                if (pieces[i - 2] == Pawn && (row == 0 || row == 7))
+                    return false;
+            }
+            return true;
+        }
+
+        /*
+         * The squares the stronger side attacks, without the unit skip (one the weak king is taking).
+         */
+        [[nodiscard]] Bitboard attacks(const Placement& placement, Bitboard occupied, int skip = -1) const {
+            Bitboard attacked = king_attacks[placement.squares[0]];
+            for (int i = 2; i < units; i++)
+                if (i != skip)
+                    attacked |= piece_attacks(pieces[i - 2], placement.squares[i], occupied);
+            return attacked;
+        }
+
+        [[nodiscard]] bool weak_in_check(const Placement& placement) const {
+            return attacks(placement, occupied(placement)) & square_bit(placement.squares[1]);
+        }
+
+        /*
+         * The weak king's legal moves, taking a piece included.
+         */
+        [[nodiscard]] int weak_moves(const Placement& placement) const {
+            Bitboard occupied = this->occupied(placement);
+            int king = placement.squares[1];
+            Bitboard targets = king_attacks[king] & ~king_attacks[placement.squares[0]];
+            int moves = 0;
+            while (targets) {
+                int target = pop_first_square(targets);
+                int taken = -1;
+                for (int i = 2; i < units; i++)
+                    if (placement.squares[i] == target)
+                        taken = i;
+                // The king's own square is left empty, a slider sees through it.
+                Bitboard after = (occupied & ~square_bit(king)) | square_bit(target);
+                if (!(attacks(placement, after, taken) & square_bit(target)))
+                    moves++;
+            }
+            return moves;
+        }
+
+        /*
+         * The positions with the stronger side to move that have a move to this one, where the weak side is to move.
+         */
+        template<typename Visit>
+        void strong_predecessors(const Placement& placement, Visit visit) const {
+            Bitboard occupied = this->occupied(placement);
+            int weak_king = placement.squares[1];
+            for (int unit = 0; unit < units; unit++) {
+                if (unit == 1)
+                    continue;
+                int square = placement.squares[unit];
+                Bitboard sources;
+                if (unit == 0) {
+                    sources = king_attacks[square] & ~occupied & ~king_attacks[weak_king];
+                } else if (pieces[unit - 2] == Pawn) {
+                    sources = 0;
+                    int row = square / 8;
+                    if (row <= 5 && !(occupied & square_bit(square + 8))) {
+                        sources |= square_bit(square + 8);
+                        if (row == 4 && !(occupied & square_bit(square + 16)))
+                            sources |= square_bit(square + 16);
+                    }
+                } else {
+                    sources = piece_attacks(pieces[unit - 2], square, occupied) & ~occupied;
+                }
+                while (sources) {
+                    int source = pop_first_square(sources);
+                    Placement before = placement;
+                    before.strong_to_move = true;
+                    before.squares[unit] = source;
+                    // The weak side can't have been left in check.
+                    if (attacks(before, occupied ^ square_bit(square) ^ square_bit(source)) & square_bit(weak_king))
+                        continue;
+                    visit(index(before));
+                }
+            }
+        }
+
+        /*
+         * The positions with the weak side to move that have a king move to this one. Pieces it took aren't put back,
+         * those positions belong to a larger ending.
+         */
+        template<typename Visit>
+        void weak_predecessors(const Placement& placement, Visit visit) const {
+            Bitboard sources = king_attacks[placement.squares[1]] & ~occupied(placement) & ~king_attacks[placement.squares[0]];
+            while (sources) {
+                Placement before = placement;
+                before.strong_to_move = false;
+                before.squares[1] = pop_first_square(sources);
+                visit(index(before));
+            }
+        }
+
+        const std::vector<Pieces>& pieces;
+        int units;
+        size_t half;
+    };
+
+    void set_bit(std::vector<uint64_t>& bits, size_t index) {
+        bits[index / 64] |= uint64_t{1} << (index % 64);
+    }
+
+    template<typename Visit>
+    void for_each_bit(const std::vector<uint64_t>& bits, Visit visit) {
+        for (size_t word = 0; word < bits.size(); word++) {
+            uint64_t remaining = bits[word];
+            while (remaining)
+                visit(word * 64 + pop_first_square(remaining));
+        }
+    }
+}
+
+Bitbase Bitbase::generate(std::vector<Pieces> pieces, const Bitbase* queen, const Bitbase* rook) {
+    Bitbase bitbase(std::move(pieces));
+    Generator generator(bitbase.pieces);
+    size_t half = generator.half;
+    bitbase.wins.assign(bitbase.size() / 64, 0);
+
+    // The weak side's moves that aren't yet known to lose, for each position with it to move.
+    std::vector<uint8_t> escapes(half, 0);
+    std::vector<uint64_t> strong_frontier(half / 64, 0), weak_frontier(half / 64, 0);
+
+    for (size_t i = 0; i < half; i++) {
+        auto placement = generator.placement(half + i);
+        if (!generator.placed(placement))
+            continue;
+        int moves = generator.weak_moves(placement);
+        escapes[i] = (uint8_t)moves;
+        if (moves == 0 && generator.weak_in_check(placement)) {
+            set_bit(bitbase.wins, half + i);
+            set_bit(weak_frontier, i);
+        }
+    }
+
+    if (bitbase.pieces.size() == 1 && bitbase.pieces[0] == Pawn) {
+        for (size_t i = 0; i < half; i++) {
+            auto placement = generator.placement(i);
+            int pawn = placement.squares[2];
+            if (pawn / 8 != 1 || !generator.placed(placement) || generator.weak_in_check(placement))
+                continue;
+            int promotion = pawn - 8;
+            if (generator.occupied(placement) & square_bit(promotion))
+                continue;
+            for (auto promoted: {queen, rook}) {
+                if (promoted && !promoted->wins.empty() && promoted->won(promoted->index(false, placement.squares[0], placement.squares[1], promotion))) {
+                    set_bit(bitbase.wins, i);
+                    set_bit(strong_frontier, i);
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<uint64_t> next_strong(half / 64), next_weak(half / 64);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::fill(next_strong.begin(), next_strong.end(), 0);
+        std::fill(next_weak.begin(), next_weak.end(), 0);
+        for_each_bit(weak_frontier, [&](size_t i) {
+            generator.strong_predecessors(generator.placement(half + i), [&](size_t before) {
+                if (!bitbase.won(before)) {
+                    set_bit(bitbase.wins, before);
+                    set_bit(next_strong, before);
+                    changed = true;
+                }
+            });
+        });
+        for_each_bit(strong_frontier, [&](size_t i) {
+            generator.weak_predecessors(generator.placement(i), [&](size_t before) {
+                auto& remaining = escapes[before - half];
+                if (remaining > 0 && !bitbase.won(before) && --remaining == 0) {
+                    set_bit(bitbase.wins, before);
+                    set_bit(next_weak, before - half);
+                    changed = true;
+                }
+            });
+        });
+        std::swap(strong_frontier, next_strong);
+        std::swap(weak_frontier, next_weak);
+    }
+    return bitbase;
+}
+
+bool Bitbase::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::vector<uint64_t> loaded(size() / 64);
+    in.read(reinterpret_cast<char*>(loaded.data()), (std::streamsize)(loaded.size() * sizeof(uint64_t)));
+    // Exactly the right size, anything else was written for other pieces or cut short.
+    if (!in || in.peek() != std::char_traits<char>::eof())
+        return false;
+    wins = std::move(loaded);
+    return true;
+}
+
+bool Bitbase::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+    out.write(reinterpret_cast<const char*>(wins.data()), (std::streamsize)(wins.size() * sizeof(uint64_t)));
+    return (bool)out;
+}
+
+static std::vector<Pieces> ending_pieces(Bitbases::Ending ending) {
+    switch (ending) {
+        case Bitbases::KPK: return {Pawn};
+        case Bitbases::KRK: return {Rook};
+        case Bitbases::KQK: return {Queen};
+        case Bitbases::KBNK: return {Bishop, Knight};
+    }
+    return {};
+}
+
+void Bitbases::generate(const std::vector<Ending>& which) {
+    auto wanted = [&](Ending ending) {
+        return std::find(which.begin(), which.end(), ending) != which.end();
+    };
+    // KPK promotes into KQK and KRK, so those come first.
+    for (auto ending: {KRK, KQK, KPK, KBNK}) {
+        bool promoted_into = (ending == KRK || ending == KQK) && wanted(KPK);
+        if (!wanted(ending) && !promoted_into)
+            continue;
+        if (ending == KPK)
+            endings[KPK] = Bitbase::generate({Pawn}, &endings[KQK], &endings[KRK]);
+        else
+            endings[ending] = Bitbase::generate(ending_pieces(ending));
+    }
+}
+
+bool Bitbases::load(const std::string& directory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    bool saved = true;
+    for (auto ending: {KRK, KQK, KPK, KBNK}) {
+        auto path = (std::filesystem::path(directory) / (std::string(NAMES[ending]) + ".bitbase")).string();
+        endings[ending] = Bitbase(ending_pieces(ending));
+        if (endings[ending].load(path))
+            continue;
+        if (ending == KPK)
+            endings[KPK] = Bitbase::generate({Pawn}, &endings[KQK], &endings[KRK]);
+        else
+            endings[ending] = Bitbase::generate(ending_pieces(ending));
+        saved = endings[ending].save(path) && saved;
+    }
+    return saved;
+}
+
+std::optional<WinDrawLoss> Bitbases::probe(const Board& board) const {
+    Bitboard occupied = board.occupied();
+    if (count_squares(occupied) > 4)
+        return std::nullopt;
+    Bitboard white_king = board.get_piece_board(King, White), black_king = board.get_piece_board(King, Black);
+    if (count_squares(white_king) != 1 || count_squares(black_king) != 1)
+        return std::nullopt;
+
+    Bitboard others = occupied & ~white_king & ~black_king;
+    std::array<int, 2> squares{};
+    std::array<Piece, 2> found{};
+    int count = 0;
+    while (others) {
+        squares[count] = pop_first_square(others);
+        found[count] = board.get_piece_at(square_position(squares[count]));
+        count++;
+    }
+    if (count == 0)
+        return Draw;
+    Side strong = found[0].side;
+    if (count == 2 && found[1].side != strong)
+        return std::nullopt;
+
+    const Bitbase* bitbase = nullptr;
+    if (count == 1) {
+        switch (found[0].type) {
+            case Pawn: bitbase = &endings[KPK]; break;
+            case Rook: bitbase = &endings[KRK]; break;
+            case Queen: bitbase = &endings[KQK]; break;
+            // A lone minor piece can't mate.
+            default: return Draw;
+        }
+    } else if (found[0].type == Knight && found[1].type == Knight) {
+        // Two knights can mate, but can't force it.
+        return Draw;
+    } else if (found[0].type == Bishop && found[1].type == Knight) {
+        bitbase = &endings[KBNK];
+    } else if (found[0].type == Knight && found[1].type == Bishop) {
+        bitbase = &endings[KBNK];
+        std::swap(squares[0], squares[1]);
+    } else {
+        return std::nullopt;
+    }
+    if (bitbase->wins.empty())
+        return std::nullopt;
+
+    // The tables have White as the stronger side, Black's pieces are looked up with the board upside down.
+    int flip = strong == White ? 0 : 56;
+    Bitboard strong_king = strong == White ? white_king : black_king;
+    Bitboard weak_king = strong == White ? black_king : white_king;
+    bool strong_to_move = board.side_to_move() == strong;
+    auto index = bitbase->index(strong_to_move, first_square(strong_king) ^ flip, first_square(weak_king) ^ flip,
+                                squares[0] ^ flip, squares[1] ^ flip);
+    if (!bitbase->won(index))
+        return Draw;
+    return strong_to_move ? Win : Loss;
+}
+
+static int king_distance(int a, int b) {
+    return std::max(std::abs(a / 8 - b / 8), std::abs(a % 8 - b % 8));
+}
+
+int Bitbases::progress(const Board& board) {
+    Side strong = NoSide;
+    for (auto side: {White, Black})
+        for (auto type: {Pawn, Knight, Bishop, Rook, Queen})
+            if (board.get_piece_board(type, side))
+                strong = side;
+    if (strong == NoSide)
+        return 0;
+    Side weak = strong == White ? Black : White;
+    int strong_king = first_square(board.get_piece_board(King, strong));
+    int weak_king = first_square(board.get_piece_board(King, weak));
+    if (strong_king >= 64 || weak_king >= 64)
+        return 0;
+
+    int score = 10 * (7 - king_distance(strong_king, weak_king));
+    Bitboard pawns = board.get_piece_board(Pawn, strong);
+    Bitboard bishops = board.get_piece_board(Bishop, strong);
+    if (pawns) {
+        int row = first_square(pawns) / 8;
+        score += 20 * (strong == White ? 6 - row : row - 1);
+    } else if (bishops && board.get_piece_board(Knight, strong)) {
+        // Only the corners of the bishop's colour can be mated in. a8 and h1 are the light ones.
+        int bishop = first_square(bishops);
+        bool light = (bishop / 8 + bishop % 8) % 2 == 0;
+        int corners[2] = {light ? 0 : 7, light ? 63 : 56};
+        int distance = 14;
+        for (int corner: corners)
+            distance = std::min(distance, std::abs(weak_king / 8 - corner / 8) + std::abs(weak_king % 8 - corner % 8));
+        score += 20 * (14 - distance);
+    } else {
+        int row = weak_king / 8, column = weak_king % 8;
+        score += 20 * (std::max(3 - row, row - 4) + std::max(3 - column, column - 4));
+    }
+    return score;
+}
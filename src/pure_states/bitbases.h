@@ -0,0 +1,112 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#ifndef CHESS_BITBASES_H
+#define CHESS_BITBASES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "board.h"
+
+/*
+ * The result with best play, for the side to move.
+ */
+enum WinDrawLoss {
+    Loss,
+    Draw,
+    Win
+};
+
+/*
+ * Whether the stronger side wins every position of an ending where the other side only has its king, one bit a position.
+ * The other side can never win these, so a clear bit is a draw.
+ *
+ * The stronger side is always taken to be White, a position with Black stronger is looked up with the rows flipped.
+ * A position is indexed by whose move it is, the kings' squares and the stronger side's pieces' squares, in the order of pieces:
+ *  ((((turn * 64 + strong king) * 64 + weak king) * 64 + first piece) * 64 + second piece), turn being 0 for the stronger side.
+ * Positions that can't happen are kept as draws, it's quicker to index every square than to skip them.
+ */
+struct Bitbase {
+    Bitbase() = default;
+    explicit Bitbase(std::vector<Pieces> pieces);
+
+    [[nodiscard]] size_t size() const {
+        return (size_t)2 << (6 * (2 + pieces.size()));
+    }
+
+    [[nodiscard]] size_t index(bool strong_to_move, int strong_king, int weak_king, int first, int second = 0) const {
+        size_t index = ((size_t)(strong_to_move ? 0 : 1) * 64 + strong_king) * 64 + weak_king;
+        index = index * 64 + first;
+        if (pieces.size() > 1)
+            index = index * 64 + second;
+        return index;
+    }
+
+    [[nodiscard]] bool won(size_t index) const {
+        return (wins[index / 64] >> (index % 64)) & 1;
+    }
+
+    /*
+     * Works every position out backwards from the checkmates (retrograde analysis).
+     * Checkmated positions are lost for the side to move. A position is won if a move reaches a lost one,
+     * and lost if every move reaches a won one. Positions left when nothing more changes are draws.
+     * Each round only goes back from the positions the last round decided, so every position is only gone back from once.
+     * A pawn's promotions are looked up in the queen and rook bitbases, which have to be generated first.
+     */
+    static Bitbase generate(std::vector<Pieces> pieces, const Bitbase* queen = nullptr, const Bitbase* rook = nullptr);
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    std::vector<Pieces> pieces;
+    std::vector<uint64_t> wins;
+};
+
+/*
+ * Bitbases for the endings that can be won against a lone king with a pawn, a rook, a queen, or a bishop and knight.
+ * Kings alone, or with a lone bishop or knight, are known draws without one.
+ */
+struct Bitbases {
+    enum Ending {
+        KPK,
+        KRK,
+        KQK,
+        KBNK
+    };
+
+    static constexpr std::array<const char*, 4> NAMES{"kpk", "krk", "kqk", "kbnk"};
+
+    /*
+     * Loads each bitbase from the directory, generating and saving the ones that aren't there yet.
+     * KBNK takes several seconds to generate, the rest a fraction of one.
+     * Returns false if one couldn't be saved, they are all loaded anyway.
+     */
+    bool load(const std::string& directory);
+
+    /*
+     * Generates the bitbases in memory without saving them, and the ones KPK promotes into along with it.
+     */
+    void generate(const std::vector<Ending>& which = {KPK, KRK, KQK, KBNK});
+
+    /*
+     * The result for the side to move, if the position is one of the endings. Castling and the move counters are ignored.
+     */
+    [[nodiscard]] std::optional<WinDrawLoss> probe(const Board& board) const;
+
+    /*
+     * How close the stronger side is to winning, for choosing between won positions when the win is too far away to search:
+     * the weak king driven to the edge (to a corner the bishop covers with a bishop and knight), the kings close together and the pawn forward.
+     * Higher is closer, 0 to a few hundred.
+     */
+    [[nodiscard]] static int progress(const Board& board);
+
+    std::array<Bitbase, 4> endings;
+};
+
+#endif //CHESS_BITBASES_H
@@ -0,0 +1,122 @@
+//
+// Created by Chris Luttio on 1/13/22.
+//
+
+#include "bitboard.h"
+
+#include <vector>
+
+std::array<Magic, 64> rook_magics;
+std::array<Magic, 64> bishop_magics;
+std::array<std::array<Bitboard, 64>, 64> squares_between;
+
+namespace {
+    std::vector<Bitboard> rook_table(0x19000);
+    std::vector<Bitboard> bishop_table(0x1480);
+
+    /*
+     * Found offline by a random search over sparse 64-bit numbers (and checked by bitboard_tests).
+     * They depend on the square numbering, so they have to be searched again if it ever changes.
+     */
+    constexpr std::array<Bitboard, 64> rook_magic_numbers{
+            0x0480046281400010ULL, 0x80C0200010004000ULL, 0x8780200008300180ULL, 0x8880060800100080ULL,
+            0x2100030010080084ULL, 0x0100040001000802ULL, 0x0200040800810200ULL, 0x0580008002407100ULL,
+            0x1000800080400020ULL, 0x0080401000402001ULL, 0x800C802002100880ULL, 0x800A002200884010ULL,
+            0x2046002008108600ULL, 0x0222009002000804ULL, 0x100B000421001200ULL, 0x0240800100004080ULL,
+            0x4540008020408006ULL, 0x8010054020084002ULL, 0x7D10010100200040ULL, 0x1408008010000882ULL,
+            0x4408010005000810ULL, 0x001E008004000280ULL, 0x0230040001080210ULL, 0x0000020004004081ULL,
+            0x0100400080208001ULL, 0x1000842300400100ULL, 0x1060100080200082ULL, 0x3219004B00100020ULL,
+            0x9010080080800400ULL, 0x8440020080800400ULL, 0x6008010080800200ULL, 0x4123008200010044ULL,
+            0x0280002001400240ULL, 0x0220100040400020ULL, 0x0060801003802008ULL, 0x0008100080800800ULL,
+            0x0105000801001004ULL, 0x100B000803000400ULL, 0x0000024814001021ULL, 0x00408000C2802100ULL,
+            0x4C40004020808002ULL, 0x4410500420024000ULL, 0x00C0100020008080ULL, 0x0000100008008080ULL,
+            0x8002000804220011ULL, 0x0802000804010100ULL, 0x0243100201040008ULL, 0x0000009100420014ULL,
+            0x1000400280022480ULL, 0x0020200040100040ULL, 0x00A000100800C140ULL, 0x0410001408008080ULL,
+            0x0000080004008080ULL, 0x0100020004008080ULL, 0x0303000200040300ULL, 0x1480006104008200ULL,
+            0x00008002204A1101ULL, 0x1040090010224081ULL, 0x4300C0200011000DULL, 0x8002041001002009ULL,
+            0x2005000800020411ULL, 0x110A008408100102ULL, 0x0006000108008402ULL, 0x0200002900884402ULL
+    };
+
+    constexpr std::array<Bitboard, 64> bishop_magic_numbers{
+            0x48081010008A2A80ULL, 0x000948110C0B2081ULL, 0x0944140400500000ULL, 0x4984104A00000101ULL,
+            0x4004030818283008ULL, 0x0206012462000121ULL, 0x1A02013008040001ULL, 0x0001008044200440ULL,
+            0x0000312208080880ULL, 0x0220021002009900ULL, 0x8080880801082000ULL, 0x000C11040080102AULL,
+            0x1402440421000210ULL, 0x0010120802080A81ULL, 0x0080084202104028ULL, 0x1100002082082082ULL,
+            0x0008403429080820ULL, 0x8104868204040412ULL, 0x6424084043060030ULL, 0x1108000420401000ULL,
+            0x9004101202020240ULL, 0x0032400608200412ULL, 0x0001009610822080ULL, 0x0008403429080820ULL,
+            0x0008068340104200ULL, 0x0010102858090121ULL, 0x81004C0018080313ULL, 0x4048080004820002ULL,
+            0x000900401C004049ULL, 0x0009420121C1101CULL, 0x4828504005040211ULL, 0x4828504005040211ULL,
+            0x0041041381202000ULL, 0x01008C1005601680ULL, 0x01D010900002040AULL, 0x4040020080080080ULL,
+            0x4801080200802200ULL, 0x4801080200802200ULL, 0x0010046108108080ULL, 0x90409090810A0220ULL,
+            0x8004020242201020ULL, 0x8004020242201020ULL, 0x0202010028020480ULL, 0x0000041144000801ULL,
+            0x00002000A4021080ULL, 0x0504090045040200ULL, 0x8182041102094400ULL, 0x0550008100480101ULL,
+            0xC002080404040400ULL, 0x0382004108292000ULL, 0x12000100A8040020ULL, 0xA005020442088020ULL,
+            0x2000001102020300ULL, 0x000021E0420C8808ULL, 0x3060200484888400ULL, 0x01280101021A0802ULL,
+            0x1030820110010500ULL, 0x0080012608025800ULL, 0x0002810084008800ULL, 0x800080000C208800ULL,
+            0xA408002140028204ULL, 0x0010006020322084ULL, 0x0210401044110050ULL, 0x40106000A1160020ULL
+    };
+
+    /*
+     * The squares whose occupancy matters to a slider on this square.
+     * The last square of each ray is left out, a piece there doesn't block anything behind it.
+     */
+    Bitboard relevant_mask(int square, const std::array<std::array<int, 2>, 4>& directions) {
+        Bitboard mask = 0;
+        auto [row, column] = square_position(square);
+        for (const auto& [dr, dc]: directions) {
+            for (int i = 1; i < 8; i++) {
+                BoardPosition next {row + dr * (i + 1), column + dc * (i + 1)};
+                if (!next.logical())
+                    break;
+                mask |= square_bit(BoardPosition{row + dr * i, column + dc * i});
+            }
+        }
+        return mask;
+    }
+
+    /*
+     * Enumerates every subset of each square's mask and stores its attack set in the slot the magic maps it to.
+     */
+    void init_magics(std::array<Magic, 64>& magics, std::vector<Bitboard>& table, const std::array<Bitboard, 64>& numbers, const std::array<std::array<int, 2>, 4>& directions) {
+        size_t offset = 0;
+        for (int square = 0; square < 64; square++) {
+            auto& m = magics[square];
+            m.mask = relevant_mask(square, directions);
+            m.magic = numbers[square];
+            m.shift = 64 - count_squares(m.mask);
+            m.attacks = table.data() + offset;
+
+            Bitboard subset = 0;
+            do {
+                table[offset + m.index(subset)] = sliding_attacks(square, subset, directions);
+                subset = (subset - m.mask) & m.mask;
+            } while (subset);
+            offset += size_t{1} << count_squares(m.mask);
+        }
+    }
+
+    void init_between() {
+        for (int a = 0; a < 64; a++) {
+            for (int b = 0; b < 64; b++) {
+                squares_between[a][b] = 0;
+                auto [r1, c1] = square_position(a);
+                auto [r2, c2] = square_position(b);
+                int dr = r2 - r1, dc = c2 - c1;
+                if (a == b || !(dr == 0 || dc == 0 || abs(dr) == abs(dc)))
+                    continue;
+                int sr = dr == 0 ? 0 : dr / abs(dr);
+                int sc = dc == 0 ? 0 : dc / abs(dc);
+                for (int r = r1 + sr, c = c1 + sc; r != r2 || c != c2; r += sr, c += sc)
+                    squares_between[a][b] |= square_bit(BoardPosition{r, c});
+            }
+        }
+    }
+
+    struct TableInitializer {
+        TableInitializer() {
+            init_magics(rook_magics, rook_table, rook_magic_numbers, rook_directions);
+            init_magics(bishop_magics, bishop_table, bishop_magic_numbers, bishop_directions);
+            init_between();
+        }
+    } initializer;
+}
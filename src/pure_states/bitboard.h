@@ -0,0 +1,168 @@
+//
+// Created by Chris Luttio on 1/13/22.
+//
+
+#ifndef CHESS_BITBOARD_H
+#define CHESS_BITBOARD_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "../data_types.h"
+
+/*
+ * A bitboard is a set of squares, one bit per square.
+ * Squares are numbered row by row, the same way the board is scanned: square = row * 8 + column.
+ * So bit 0 is {0, 0} (Black's back rank, a8) and bit 63 is {7, 7} (White's back rank, h1).
+ */
+using Bitboard = uint64_t;
+
+[[nodiscard]] constexpr int square_index(int row, int column) {
+    return row * 8 + column;
+}
+
+[[nodiscard]] constexpr int square_index(BoardPosition position) {
+    return square_index(position.row, position.column);
+}
+
+[[nodiscard]] constexpr BoardPosition square_position(int square) {
+    return {square / 8, square % 8};
+}
+
+[[nodiscard]] constexpr Bitboard square_bit(int square) {
+    return Bitboard{1} << square;
+}
+
+[[nodiscard]] constexpr Bitboard square_bit(BoardPosition position) {
+    return square_bit(square_index(position));
+}
+
+[[nodiscard]] constexpr int count_squares(Bitboard board) {
+    return std::popcount(board);
+}
+
+[[nodiscard]] constexpr int first_square(Bitboard board) {
+    return std::countr_zero(board);
+}
+
+constexpr int pop_first_square(Bitboard& board) {
+    int square = first_square(board);
+    board &= board - 1;
+    return square;
+}
+
+/*
+ * Attack sets for the pieces that don't slide, indexed by square.
+ * These don't depend on the other pieces on the board, so they are computed at compile time.
+ */
+namespace attack_tables {
+    [[nodiscard]] constexpr Bitboard offsets_from(int square, const std::array<std::array<int, 2>, 8>& offsets, int count) {
+        Bitboard attacks = 0;
+        auto [row, column] = square_position(square);
+        for (int i = 0; i < count; i++) {
+            BoardPosition pos {row + offsets[i][0], column + offsets[i][1]};
+            if (pos.logical())
+                attacks |= square_bit(pos);
+        }
+        return attacks;
+    }
+
+    [[nodiscard]] constexpr std::array<Bitboard, 64> knight() {
+        std::array<Bitboard, 64> table{};
+        const std::array<std::array<int, 2>, 8> offsets{{{-2, -1}, {-1, -2}, {-2, 1}, {-1, 2}, {2, -1}, {1, -2}, {2, 1}, {1, 2}}};
+        for (int square = 0; square < 64; square++)
+            table[square] = offsets_from(square, offsets, 8);
+        return table;
+    }
+
+    [[nodiscard]] constexpr std::array<Bitboard, 64> king() {
+        std::array<Bitboard, 64> table{};
+        const std::array<std::array<int, 2>, 8> offsets{{{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}}};
+        for (int square = 0; square < 64; square++)
+            table[square] = offsets_from(square, offsets, 8);
+        return table;
+    }
+
+    /*
+     * White pawns move up the board (towards row 0), Black pawns move down.
+     */
+    [[nodiscard]] constexpr std::array<std::array<Bitboard, 64>, 3> pawn() {
+        std::array<std::array<Bitboard, 64>, 3> table{};
+        const std::array<std::array<int, 2>, 8> white{{{-1, -1}, {-1, 1}}};
+        const std::array<std::array<int, 2>, 8> black{{{1, -1}, {1, 1}}};
+        for (int square = 0; square < 64; square++) {
+            table[White][square] = offsets_from(square, white, 2);
+            table[Black][square] = offsets_from(square, black, 2);
+        }
+        return table;
+    }
+}
+
+constexpr std::array<Bitboard, 64> knight_attacks = attack_tables::knight();
+constexpr std::array<Bitboard, 64> king_attacks = attack_tables::king();
+constexpr std::array<std::array<Bitboard, 64>, 3> pawn_attacks = attack_tables::pawn();
+
+const std::array<std::array<int, 2>, 4> rook_directions{{{0, -1}, {0, 1}, {-1, 0}, {1, 0}}};
+const std::array<std::array<int, 2>, 4> bishop_directions{{{-1, -1}, {-1, 1}, {1, -1}, {1, 1}}};
+
+/*
+ * Walks each direction until it leaves the board or hits a piece, the piece's square is included.
+ */
+
+[[nodiscard]] constexpr Bitboard sliding_attacks(int square, Bitboard occupied, const std::array<std::array<int, 2>, 4>& directions) {
+    Bitboard attacks = 0;
+    auto [row, column] = square_position(square);
+    for (const auto& [dr, dc]: directions) {
+        for (int i = 1; i < 8; i++) {
+            BoardPosition pos {row + dr * i, column + dc * i};
+            if (!pos.logical())
+                break;
+            attacks |= square_bit(pos);
+            if (occupied & square_bit(pos))
+                break;
+        }
+    }
+    return attacks;
+}
+
+/*
+ * Sliding attacks are looked up with magic bitboards.
+ * For each square, the pieces that can block a slider are masked out of the occupancy and multiplied by a magic number,
+ * which maps every blocker arrangement onto its own slot of a table of precomputed attack sets.
+ * The magics and tables are built once at startup, in bitboard.cpp.
+ */
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    const Bitboard* attacks;
+    int shift;
+
+    [[nodiscard]] unsigned index(Bitboard occupied) const {
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+    }
+};
+
+extern std::array<Magic, 64> rook_magics;
+extern std::array<Magic, 64> bishop_magics;
+
+/*
+ * squares_between[a][b] is the set of squares strictly between a and b when they share a row, column or diagonal, empty otherwise.
+ */
+extern std::array<std::array<Bitboard, 64>, 64> squares_between;
+
+[[nodiscard]] inline Bitboard rook_attacks(int square, Bitboard occupied) {
+    const auto& m = rook_magics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+[[nodiscard]] inline Bitboard bishop_attacks(int square, Bitboard occupied) {
+    const auto& m = bishop_magics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+[[nodiscard]] inline Bitboard queen_attacks(int square, Bitboard occupied) {
+    return rook_attacks(square, occupied) | bishop_attacks(square, occupied);
+}
+
+#endif //CHESS_BITBOARD_H
@@ -4,6 +4,10 @@
 
 #include "board.h"
 
+#include <cctype>
+#include <sstream>
+#include <tuple>
+
 using namespace std;
 
 bool Board::logical_move(const Move &move) const {
@@ -74,7 +78,8 @@ Move Board::classify_move(const Move &move) const {
                     }
                 } else if (move.diagonal() && move.vertical_movement() == side_direction) {
                     if (!is_empty_space) {
-                        type = Pawn_Attack;
+                        int back_row = piece.side == White ? 0 : 7;
+                        type = move.next.row == back_row ? Pawn_Promotion : Pawn_Attack;
                     } else {
                         if (!moves.empty()) {
                             auto last = moves.back();
@@ -208,8 +213,7 @@ bool Board::valid_move(const Move &move) const {
                         return false;
                     if (threatened({move.current.row, move.current.column - 1}, piece.side))
                         return false;
-                    auto line = line_of_sight(move.current, 0, -1);
-                    if (line.piece_indices.size() > 1)
+                    if (squares_between[square_index(move.current)][square_index(move.current.row, 0)] & occupied())
                         return false;
                     return true;
                 }
@@ -294,11 +298,119 @@ void Board::move(const Move &move) {
     }
     m.piece_id = piece.id;
     m.piece_type = piece.type;
+    if (piece.id >= 0 && piece.id < 64)
+        moved_pieces |= uint64_t{1} << piece.id;
     moves.push_back(m);
+    refresh_state_key();
+}
+
+MoveUndo Board::make_move(const Move &move) {
+    MoveUndo undo;
+    undo.captured = move.type == Pawn_EnPassant ? get_piece_at(move.current.row, move.next.column) : get_piece_at(move.next);
+    undo.last_piece_taken = last_piece_taken;
+    undo.kings = kings;
+    undo.castled = _castled;
+    undo.moved_pieces = moved_pieces;
+    undo.key = key;
+    undo.state_key = state_key;
+    this->move(move);
+    return undo;
+}
+
+/*
+ * Takes back the last move in moves, which has the moving piece's id and type filled in by Board::move.
+ */
+void Board::unmake_move(const MoveUndo &undo) {
+    Move m = moves.back();
+    moves.pop_back();
+    Side side = get_piece_at(m.next).side;
+    set_piece_at(m.current, {m.piece_type, side, m.piece_id});
+    set_piece_at(m.next);
+    switch (m.type) {
+        case King_KingSideCastle: {
+            BoardPosition rook {m.current.row, m.next.column - 1};
+            set_piece_at({m.current.row, 7}, get_piece_at(rook));
+            set_piece_at(rook);
+            break;
+        }
+        case King_QueenSideCastle: {
+            BoardPosition rook {m.current.row, m.next.column + 1};
+            set_piece_at({m.current.row, 0}, get_piece_at(rook));
+            set_piece_at(rook);
+            break;
+        }
+        case Pawn_EnPassant:
+            set_piece_at({m.current.row, m.next.column}, undo.captured);
+            break;
+        default:
+            set_piece_at(m.next, undo.captured);
+            break;
+    }
+    last_piece_taken = undo.last_piece_taken;
+    kings = undo.kings;
+    _castled = undo.castled;
+    moved_pieces = undo.moved_pieces;
+    key = undo.key;
+    state_key = undo.state_key;
+}
+
+MoveUndo Board::make_null_move() {
+    MoveUndo undo;
+    undo.last_piece_taken = last_piece_taken;
+    undo.kings = kings;
+    undo.castled = _castled;
+    undo.moved_pieces = moved_pieces;
+    undo.key = key;
+    undo.state_key = state_key;
+    auto king = kings[side_to_move()];
+    Move pass(king, king, Unclassified, get_piece_at(king).id);
+    pass.piece_type = King;
+    moves.push_back(pass);
+    refresh_state_key();
+    return undo;
+}
+
+void Board::unmake_null_move(const MoveUndo &undo) {
+    moves.pop_back();
+    key = undo.key;
+    state_key = undo.state_key;
+}
+
+/*
+ * Move is assumed to be classified.
+ * Works out whether the moving side's king would be attacked after the move by changing the occupancy instead of playing it,
+ * so the board doesn't have to be copied.
+ */
+bool Board::leaves_king_in_check(const Move &move) const {
+    auto piece = get_piece_at(move.current);
+    auto king = piece.type == King ? move.next : kings[piece.side];
+    if (!king.logical())
+        return false;
+    auto from = square_bit(move.current);
+    auto to = square_bit(move.next);
+    auto captured = to;
+    auto occupancy = (occupied() & ~from) | to;
+    switch (move.type) {
+        case Pawn_EnPassant:
+            captured = square_bit(BoardPosition{move.current.row, move.next.column});
+            occupancy &= ~captured;
+            break;
+        case King_KingSideCastle:
+            occupancy = (occupancy & ~square_bit(BoardPosition{move.current.row, 7})) | square_bit(BoardPosition{move.current.row, move.next.column - 1});
+            break;
+        case King_QueenSideCastle:
+            occupancy = (occupancy & ~square_bit(BoardPosition{move.current.row, 0})) | square_bit(BoardPosition{move.current.row, move.next.column + 1});
+            break;
+        default:
+            break;
+    }
+    auto enemies = occupied() & ~side_boards[piece.side] & ~captured;
+    return attackers_to(square_index(king), occupancy) & enemies;
 }
 
 /*
  * O(1)
+ * The board itself uses the attack tables in bitboard.h, this is kept for callers that want the squares in order.
  */
 BoardLine Board::line_of_sight(BoardPosition position, int dr, int dc) const {
     BoardLine line;
@@ -317,47 +429,23 @@ BoardLine Board::line_of_sight(BoardPosition position, int dr, int dc) const {
 }
 
 bool Board::obstructed(const Move &move) const {
-    auto line = line_of_sight(move.current, move.vertical_direction(), move.horizontal_direction());
-    if (!line.piece_indices.empty()) {
-        for (const auto& idx: line.piece_indices) {
-            auto pos = line.positions[idx];
-            auto dr = pos.row - move.current.row;
-            auto dc = pos.column - move.current.column;
-            if (move.vertical_direction() != 0)
-                dr /= move.vertical_direction();
-            else
-                dr = 0;
-            if (move.horizontal_direction() != 0)
-                dc /= move.horizontal_direction();
-            else
-                dc = 0;
-            if (dr < abs(move.vertical_movement()) || dc < abs(move.horizontal_movement()))
-                return true;
-        }
-    }
-    return false;
+    return squares_between[square_index(move.current)][square_index(move.next)] & occupied();
 }
 
 /*
- * O(n), but n is 0<n<8 so O(1)
+ * Lists the attacked squares ray by ray, nearest first, in the order of the directions given.
  */
-std::vector<BoardPosition> Board::merge_lines(const std::vector<BoardLine> &lines) {
-    std::vector<BoardPosition> positions;
-    for (const auto& list: lines) {
-        if (!list.positions.empty()) {
-            auto end = list.positions.end();
-            if (!list.piece_indices.empty()) {
-                end = list.positions.begin() + list.piece_indices[0] + 1;
-            }
-            positions.insert(positions.end(), list.positions.begin(), end);
+void Board::append_rays(std::vector<BoardPosition>& positions, BoardPosition position, Bitboard attacks, const std::array<std::array<int, 2>, 4>& directions) {
+    for (const auto& [dr, dc]: directions) {
+        for (int i = 1; i < 8; i++) {
+            BoardPosition pos {position.row + dr * i, position.column + dc * i};
+            if (!pos.logical() || !(attacks & square_bit(pos)))
+                break;
+            positions.push_back(pos);
         }
     }
-    return positions;
 }
 
-/*
- * O(32)
- */
 std::vector<BoardPosition> Board::get_threatened_positions(BoardPosition position) const {
     auto piece = get_piece_at(position);
     std::vector<BoardPosition> positions;
@@ -373,36 +461,22 @@ std::vector<BoardPosition> Board::get_threatened_positions(BoardPosition positio
                 positions.push_back(right);
             break;
         }
-        // O(16)
         case Rook: {
-            auto left = line_of_sight(position, 0, -1);
-            auto right = line_of_sight(position, 0, 1);
-            auto up = line_of_sight(position, -1, 0);
-            auto down = line_of_sight(position, 1, 0);
-            return merge_lines({left, right, up, down});
+            positions.reserve(14);
+            append_rays(positions, position, rook_attacks(square_index(position), occupied()), rook_directions);
+            break;
         }
-        // O(16)
         case Bishop: {
-            auto upper_left = line_of_sight(position, -1, -1);
-            auto upper_right = line_of_sight(position, -1, 1);
-            auto lower_left = line_of_sight(position, 1, -1);
-            auto lower_right = line_of_sight(position, 1, 1);
-            return merge_lines({upper_left, upper_right, lower_left, lower_right});
+            positions.reserve(13);
+            append_rays(positions, position, bishop_attacks(square_index(position), occupied()), bishop_directions);
+            break;
         }
-        // O(32)
         case Queen: {
-            auto left = line_of_sight(position, 0, -1);
-            auto right = line_of_sight(position, 0, 1);
-            auto up = line_of_sight(position, -1, 0);
-            auto down = line_of_sight(position, 1, 0);
-            auto upper_left = line_of_sight(position, -1, -1);
-            auto upper_right = line_of_sight(position, -1, 1);
-            auto lower_left = line_of_sight(position, 1, -1);
-            auto lower_right = line_of_sight(position, 1, 1);
-            return merge_lines({
-                left, right, up, down,
-                upper_left, upper_right, lower_left, lower_right
-            });
+            positions.reserve(27);
+            auto square = square_index(position);
+            append_rays(positions, position, rook_attacks(square, occupied()), rook_directions);
+            append_rays(positions, position, bishop_attacks(square, occupied()), bishop_directions);
+            break;
         }
         // O(8)
         case Knight: {
@@ -439,31 +513,33 @@ std::vector<BoardPosition> Board::get_threatened_positions(BoardPosition positio
 }
 
 /*
- * O(63)?
+ * Every piece, of either side, that attacks the square given the occupancy.
+ * Sliders stop at the first occupied square, so passing a different occupancy lets callers look through pieces.
+ */
+Bitboard Board::attackers_to(int square, Bitboard occupancy) const {
+    Bitboard straight = piece_boards[Rook] | piece_boards[Queen];
+    Bitboard diagonal = piece_boards[Bishop] | piece_boards[Queen];
+    return (pawn_attacks[Black][square] & get_piece_board(Pawn, White))
+         | (pawn_attacks[White][square] & get_piece_board(Pawn, Black))
+         | (knight_attacks[square] & piece_boards[Knight])
+         | (king_attacks[square] & piece_boards[King])
+         | (rook_attacks(square, occupancy) & straight)
+         | (bishop_attacks(square, occupancy) & diagonal);
+}
+
+/*
+ * Counts the pieces attacking the position that are not of the given side (or of the piece standing on it).
  */
 int Board::threatened(BoardPosition position, Side side) const {
+    if (!position.logical())
+        return 0;
     auto piece = get_piece_at(position);
-    int count = 0;
     Side color = piece.side;
     if (side != NoSide)
         color = side;
-    for (int y = 0; y < 8; y++) {
-        for (int x = 0; x < 8; x++) {
-            if (x == position.column && y == position.row)
-                continue;
-            BoardPosition p{y, x};
-            auto pp = get_piece_at(p);
-            if (pp.type == None)
-                continue;
-            if (pp.side == color)
-                continue;
-            auto positions = get_threatened_positions(p);
-            for (const auto& pos: positions)
-                if (pos == position)
-                    count++;
-        }
-    }
-    return count;
+    auto square = square_index(position);
+    auto attackers = attackers_to(square, occupied()) & ~side_boards[color] & ~square_bit(square);
+    return count_squares(attackers);
 }
 
 /*
@@ -490,133 +566,277 @@ bool Board::stalemate(Side side) const {
 }
 
 bool Board::can_move(Side side) const {
-    auto position = kings[side];
-    for (int y = 0; y < 3; y++) {
-        for (int x = 0; x < 3; x++) {
-            if (x == 1 && y == 1)
-                continue;
-            Move move {position, {position.row + y - 1, position.column + x - 1}};
-            if (legal(move))
-                return true;
-        }
-    }
-    for (int y = 0; y < 8; y++) {
-        for (int x = 0; x < 8; x++) {
-            BoardPosition pos {y, x};
-            auto piece = get_piece_at(pos);
-            if (piece.side != side || piece.type == King)
-                continue;
-            auto possible = possible_moves(pos);
-            if (!possible.empty())
-                return true;
-        }
-    }
-    return false;
+    return !legal_moves(side).empty();
 }
 
-vector<Move> Board::possible_moves(BoardPosition position) const {
-    vector<Move> possible;
+/*
+ * The square a pawn could take en passant on, or -1.
+ * Only the last move matters, so this is read from the move history.
+ */
+int Board::en_passant_square() const {
+    if (moves.empty())
+        return -1;
+    const auto& last = moves.back();
+    if (last.type != Pawn_DoubleMove)
+        return -1;
+    auto pawn = get_piece_at(last.next);
+    if (pawn.type != Pawn)
+        return -1;
+    return square_index((last.current.row + last.next.row) / 2, last.next.column);
+}
 
-    auto piece = get_piece_at(position);
-    int side_direction = piece.side == White ? -1 : 1;
-    int back_row = piece.side == White ? 7 : 0;
+/*
+ * Generates every legal move for a side, already classified, without trying any of them on a board.
+ *
+ * The king's attackers and the pieces pinned to it are worked out once:
+ *  if the king is in check by one piece, every other piece has to take that piece or step between it and the king,
+ *  if it is in check by two, only the king can move,
+ *  a pinned piece can only move along the line between the king and the piece pinning it.
+ * King moves are checked by looking at attackers of the destination with the king taken off the board,
+ * so the king can't step back along the line of a slider checking it.
+ * En passant can uncover an attack along the row of both pawns, so it is the one move still checked by simulating it.
+ *
+ * Only pieces on the squares in from are moved.
+ */
+MoveList Board::legal_moves(Side side, Bitboard from) const {
+    MoveList list;
+    legal_moves(side, list, from);
+    return list;
+}
 
-    switch (piece.type) {
-        case Pawn: {
-            Move pawn_move {position, {position.row + side_direction, position.column}};
-            if (legal(pawn_move))
-                possible.push_back(pawn_move);
-            Move pawn_double_move {position, {position.row + 2 * side_direction, position.column}};
-            if (legal(pawn_double_move))
-                possible.push_back(pawn_double_move);
-            Move left_attack {position, {position.row + side_direction, position.column - 1}};
-            if (legal(left_attack))
-                possible.push_back(left_attack);
-            Move right_attack {position, {position.row + side_direction, position.column + 1}};
-            if (legal(right_attack))
-                possible.push_back(right_attack);
-            break;
+void Board::legal_moves(Side side, MoveList& list, Bitboard from) const {
+    list.clear();
+
+    Side enemy_side = side == White ? Black : White;
+    Bitboard own = side_boards[side];
+    Bitboard enemies = side_boards[enemy_side];
+    Bitboard occupancy = own | enemies;
+
+    Bitboard king_board = get_piece_board(King, side);
+    int king = king_board ? first_square(king_board) : -1;
+
+    Bitboard check_mask = ~Bitboard{0};
+    Bitboard pinned = 0;
+    std::array<Bitboard, 64> pin_rays{};
+    int checks = 0;
+
+    if (king != -1) {
+        Bitboard checkers = attackers_to(king, occupancy) & enemies;
+        checks = count_squares(checkers);
+        if (checks == 1) {
+            int checker = first_square(checkers);
+            check_mask = squares_between[king][checker] | checkers;
+        } else if (checks > 1) {
+            check_mask = 0;
         }
-        case Rook: {
-            for (int x = 0; x < 8; x++) {
-                Move horizontal {position, {position.row, x}};
-                if (legal(horizontal))
-                    possible.push_back(horizontal);
-            }
-            for (int y = 0; y < 8; y++) {
-                Move vertical {position, {y, position.column}};
-                if (legal(vertical))
-                    possible.push_back(vertical);
+
+        Bitboard snipers = ((rook_attacks(king, 0) & (piece_boards[Rook] | piece_boards[Queen]))
+                          | (bishop_attacks(king, 0) & (piece_boards[Bishop] | piece_boards[Queen]))) & enemies;
+        while (snipers) {
+            int sniper = pop_first_square(snipers);
+            Bitboard blockers = squares_between[king][sniper] & occupancy;
+            if (count_squares(blockers) == 1 && (blockers & own)) {
+                pinned |= blockers;
+                pin_rays[first_square(blockers)] = squares_between[king][sniper] | square_bit(sniper);
             }
-            break;
         }
-        case Bishop: {
-            for (const auto& [y, x]: vector<tuple<int, int>>{{-1, -1}, {1, -1}, {-1, 1}, {1, 1}}) {
-                for (int i = 0; i < 8; i++) {
-                    Move move {position, {position.row + y * i, position.column + x * i}};
-                    if (legal(move))
-                        possible.push_back(move);
-                }
-            }
-            break;
+    }
+
+    auto add = [&](int origin, Bitboard targets, move_type type, Pieces piece_type) {
+        auto current = square_position(origin);
+        while (targets) {
+            auto next = square_position(pop_first_square(targets));
+            Move move {current, next, type};
+            move.piece_type = piece_type;
+            move.piece_id = pieces[current.row][current.column].id;
+            list.push_back(move);
         }
-        case Queen: {
-            for (int x = 0; x < 8; x++) {
-                Move horizontal {position, {position.row, x}};
-                if (legal(horizontal))
-                    possible.push_back(horizontal);
-            }
-            for (int y = 0; y < 8; y++) {
-                Move vertical {position, {y, position.column}};
-                if (legal(vertical))
-                    possible.push_back(vertical);
-            }
-            for (const auto& [y, x]: vector<tuple<int, int>>{{-1, -1}, {1, -1}, {-1, 1}, {1, 1}}) {
-                for (int i = 0; i < 8; i++) {
-                    Move move {position, {position.row + y * i, position.column + x * i}};
-                    if (legal(move))
-                        possible.push_back(move);
-                }
+    };
+
+    auto add_promotions = [&](int origin, Bitboard targets) {
+        auto current = square_position(origin);
+        while (targets) {
+            auto next = square_position(pop_first_square(targets));
+            for (auto promotion: {Queen, Rook, Bishop, Knight}) {
+                Move move {current, next, Pawn_Promotion};
+                move.promotion = promotion;
+                move.piece_type = Pawn;
+                move.piece_id = pieces[current.row][current.column].id;
+                list.push_back(move);
             }
-            break;
         }
-        case Knight: {
-            for (const auto& [y, x]: vector<tuple<int, int>>{{-1, -1}, {-1, 1}, {1, -1}, {1, 1}}) {
-                for (const auto& [a, b]: vector<tuple<int, int>>{{2, 1}, {1, 2}}) {
-                    auto r = y * a + position.row;
-                    auto c = x * b + position.column;
-                    BoardPosition pos{r, c};
-                    Move move {position, pos};
-                    if (legal(move)) {
-                        possible.push_back(move);
-                    }
+    };
+
+    Bitboard movers = own & from;
+    if (checks > 1)
+        movers &= king_board;
+
+    int direction = side == White ? -1 : 1;
+    int starting_row = side == White ? 6 : 1;
+    int back_row = side == White ? 0 : 7;
+    int en_passant = en_passant_square();
+
+    while (movers) {
+        int origin = pop_first_square(movers);
+        auto [row, column] = square_position(origin);
+        auto type = pieces[row][column].type;
+        Bitboard allowed = check_mask & ((pinned & square_bit(origin)) ? pin_rays[origin] : ~Bitboard{0});
+
+        switch (type) {
+            case Pawn: {
+                Bitboard pushes = 0, double_pushes = 0;
+                BoardPosition one {row + direction, column};
+                if (one.logical() && !(occupancy & square_bit(one))) {
+                    pushes = square_bit(one);
+                    BoardPosition two {row + 2 * direction, column};
+                    if (row == starting_row && !(occupancy & square_bit(two)))
+                        double_pushes = square_bit(two);
                 }
-            }
-            break;
-        }
-        case King: {
-            for (int y = 0; y < 3; y++) {
-                for (int x = 0; x < 3; x++) {
-                    if (x == 1 && y == 1)
-                        continue;
-                    Move move {position, {position.row + y - 1, position.column + x - 1}};
-                    if (legal(move))
-                        possible.push_back(move);
+                Bitboard attacks = pawn_attacks[side][origin] & enemies;
+                pushes &= allowed;
+                double_pushes &= allowed;
+                attacks &= allowed;
+                if (row + direction == back_row) {
+                    add_promotions(origin, pushes | attacks);
+                } else {
+                    add(origin, pushes, Pawn_Move, Pawn);
+                    add(origin, double_pushes, Pawn_DoubleMove, Pawn);
+                    add(origin, attacks, Pawn_Attack, Pawn);
                 }
+                if (en_passant != -1 && (pawn_attacks[side][origin] & square_bit(en_passant)) &&
+                    pieces[row][en_passant % 8].side == enemy_side) {
+                    Move move {{row, column}, square_position(en_passant), Pawn_EnPassant};
+                    move.piece_type = Pawn;
+                    move.piece_id = pieces[row][column].id;
+                    if (!leaves_king_in_check(move))
+                        list.push_back(move);
+                }
+                break;
             }
-            if (position.row == back_row && position.column == 4) {
-                Move move1 {position, {back_row, 6}};
-                if (legal(move1))
-                    possible.push_back(move1);
-                Move move2 {position, {back_row, 2}};
-                if (legal(move2))
-                    possible.push_back(move2);
+            case Knight:
+                add(origin, knight_attacks[origin] & ~own & allowed, Knight_Move, Knight);
+                break;
+            case Bishop:
+                add(origin, bishop_attacks(origin, occupancy) & ~own & allowed, Bishop_Move, Bishop);
+                break;
+            case Rook:
+                add(origin, rook_attacks(origin, occupancy) & ~own & allowed, Rook_Move, Rook);
+                break;
+            case Queen:
+                add(origin, queen_attacks(origin, occupancy) & ~own & allowed, Queen_Move, Queen);
+                break;
+            case King: {
+                Bitboard without_king = occupancy & ~square_bit(origin);
+                Bitboard targets = king_attacks[origin] & ~own;
+                Bitboard safe = 0;
+                while (targets) {
+                    int target = pop_first_square(targets);
+                    if (!(attackers_to(target, without_king) & enemies))
+                        safe |= square_bit(target);
+                }
+                add(origin, safe, King_Move, King);
+
+                int rights = castling_rights() & (side == White ? WhiteKingSide | WhiteQueenSide : BlackKingSide | BlackQueenSide);
+                if (checks == 0 && rights) {
+                    auto clear = [&](int rook_column) {
+                        return !(squares_between[origin][square_index(row, rook_column)] & occupancy);
+                    };
+                    auto safe_square = [&](int c) {
+                        return !(attackers_to(square_index(row, c), occupancy) & enemies);
+                    };
+                    if ((rights & (WhiteKingSide | BlackKingSide)) && clear(7) && safe_square(5) && safe_square(6))
+                        add(origin, square_bit(square_index(row, 6)), King_KingSideCastle, King);
+                    if ((rights & (WhiteQueenSide | BlackQueenSide)) && clear(0) && safe_square(3) && safe_square(2))
+                        add(origin, square_bit(square_index(row, 2)), King_QueenSideCastle, King);
+                }
+                break;
             }
-            break;
+            default:
+                break;
         }
-        default:
-            break;
+    }
+}
+
+vector<Move> Board::possible_moves(BoardPosition position) const {
+    auto piece = get_piece_at(position);
+    if (piece.type == None)
+        return {};
+    auto moves = legal_moves(piece.side, square_bit(position));
+    return {moves.begin(), moves.end()};
+}
+
+bool Board::load_fen(Board& board, const std::string& fen) {
+    std::istringstream fields(fen);
+    std::string placement, turn, castling = "-", en_passant = "-";
+    if (!(fields >> placement >> turn))
+        return false;
+    fields >> castling >> en_passant;
+
+    int row = 0, column = 0;
+    for (char c: placement) {
+        if (c == '/') {
+            if (column != 8)
+                return false;
+            row++;
+            column = 0;
+            continue;
+        }
+        if (c >= '1' && c <= '8') {
+            column += c - '0';
+            continue;
+        }
+        Pieces type;
+        switch (tolower(c)) {
+            case 'p': type = Pawn; break;
+            case 'n': type = Knight; break;
+            case 'b': type = Bishop; break;
+            case 'r': type = Rook; break;
+            case 'q': type = Queen; break;
+            case 'k': type = King; break;
+            default: return false;
+        }
+        if (row >= 8 || column >= 8)
+            return false;
+        board.set_piece_at(row, column++, {type, isupper(c) ? White : Black});
+    }
+    if (row != 7 || column != 8)
+        return false;
+
+    if (turn != "w" && turn != "b")
+        return false;
+    board.first_turn = turn == "w" ? White : Black;
+
+    auto mark_moved = [&](int r, int c) {
+        auto piece = board.get_piece_at(r, c);
+        if (piece.id >= 0 && piece.id < 64)
+            board.moved_pieces |= uint64_t{1} << piece.id;
+    };
+    for (auto side: {White, Black}) {
+        int back_row = side == White ? 7 : 0;
+        bool king_side = castling.find(side == White ? 'K' : 'k') != std::string::npos;
+        bool queen_side = castling.find(side == White ? 'Q' : 'q') != std::string::npos;
+        if (!king_side && !queen_side)
+            mark_moved(back_row, 4);
+        if (!king_side)
+            mark_moved(back_row, 7);
+        if (!queen_side)
+            mark_moved(back_row, 0);
     }
 
-    return possible;
-}
\ No newline at end of file
+    if (en_passant.size() == 2 && en_passant[0] >= 'a' && en_passant[0] <= 'h' && (en_passant[1] == '3' || en_passant[1] == '6')) {
+        int target_column = en_passant[0] - 'a';
+        int target_row = '8' - en_passant[1];
+        int direction = target_row == 5 ? -1 : 1;
+        BoardPosition from {target_row - direction, target_column};
+        BoardPosition to {target_row + direction, target_column};
+        auto pawn = board.get_piece_at(to);
+        if (pawn.type == Pawn) {
+            Move double_move(from, to, Pawn_DoubleMove, pawn.id);
+            double_move.piece_type = Pawn;
+            board.moves.push_back(double_move);
+            board.first_turn = pawn.side;
+        }
+    }
+    board.refresh_state_key();
+    return true;
+}
@@ -5,12 +5,38 @@
 #ifndef CHESS_BOARD_H
 #define CHESS_BOARD_H
 
+#include <algorithm>
+#include <string>
 #include <vector>
 
 #include "../data_types.h"
+#include "bitboard.h"
+#include "evaluation.h"
+#include "zobrist.h"
+
+/*
+ * Everything Board::move overwrites that can't be worked out again from the move itself.
+ * The en passant square isn't here because it is read from the last entry of moves, which make_move pushes and unmake_move pops.
+ */
+struct MoveUndo {
+    Piece captured;
+    Pieces last_piece_taken;
+    std::array<BoardPosition, 3> kings;
+    std::array<bool, 3> castled;
+    uint64_t moved_pieces;
+    uint64_t key;
+    uint64_t state_key;
+};
+
+enum CastlingRights {
+    WhiteKingSide = 1,
+    WhiteQueenSide = 2,
+    BlackKingSide = 4,
+    BlackQueenSide = 8,
+};
 
 struct Board {
-    Board(): pieces(), piece_id(1), kings() {
+    Board(): pieces(), piece_id(1), kings(), piece_boards(), side_boards(), moved_pieces(0), first_turn(White), key(0), totals(), state_key(0) {
         for (int i = 0; i < 3; i++)
             kings[i] = {-1, -1};
         _castled = {false, false, false};
@@ -35,17 +61,21 @@ struct Board {
         }
     }
 
+    /*
+     * Sets up an empty board from Forsyth-Edwards Notation, returns false if the placement or side to move can't be read.
+     * Castling rights that are missing are recorded by marking the king or rook as moved,
+     * and an en passant square by adding the double pawn move that made it to moves.
+     * The move counters are ignored.
+     */
+    static bool load_fen(Board& board, const std::string& fen);
+
     [[nodiscard]] bool legal(Move& move) const {
         if (!logical_move(move))
             return false;
         move = classify_move(move);
         if (move.type == Unclassified)
             return false;
-        Board imaginary = *this;
-        imaginary.move(move);
-        auto piece = get_piece_at(move.current);
-        bool will_be_in_check = imaginary.king_in_check(piece.side);
-        if (will_be_in_check)
+        if (leaves_king_in_check(move))
             return false;
         if (!valid_move(move))
             return false;
@@ -56,17 +86,15 @@ struct Board {
         move = classify_move(move);
         if (move.type == Unclassified)
             return false;
-        Board imaginary = *this;
-        imaginary.move(move);
-        auto piece = get_piece_at(move.current);
-        bool will_be_in_check = imaginary.king_in_check(piece.side);
-        if (will_be_in_check)
+        if (leaves_king_in_check(move))
             return false;
         if (!valid_move(move))
             return false;
         return true;
     }
 
+    [[nodiscard]] bool leaves_king_in_check(const Move&) const;
+
     [[nodiscard]] bool logical_move(const Move &move) const;
     [[nodiscard]] bool valid_move(const Move&) const;
 
@@ -74,6 +102,21 @@ struct Board {
 
     void move(const Move&);
 
+    /*
+     * Plays a move in place and returns what is needed to take it back.
+     * Moves have to be unmade in the reverse order they were made.
+     */
+    MoveUndo make_move(const Move&);
+    void unmake_move(const MoveUndo&);
+
+    /*
+     * Passes the turn to the other side, for the search's null-move pruning.
+     * It goes into moves as the king moving onto its own square, so the side to move still follows from the last move
+     * and there is no en passant capture after it. The side to move must have a king.
+     */
+    MoveUndo make_null_move();
+    void unmake_null_move(const MoveUndo&);
+
     [[nodiscard]] Piece get_piece_at(int row, int column) const {
         if (row < 0 || row >= 8 || column < 0 || column >= 8)
             return {};
@@ -89,19 +132,63 @@ struct Board {
             p.id = piece_id++;
         if (p.id != -1 && p.type == King)
             kings[p.side] = {row, column};
+        int square = square_index(row, column);
+        auto bit = square_bit(square);
+        auto& previous = pieces[row][column];
+        piece_boards[previous.type] &= ~bit;
+        side_boards[previous.side] &= ~bit;
+        if (previous.type != None) {
+            key ^= zobrist::keys.pieces[previous.side][previous.type][square];
+            totals.remove(previous.side, previous.type, square);
+        }
+        if (p.type != None) {
+            piece_boards[p.type] |= bit;
+            side_boards[p.side] |= bit;
+            key ^= zobrist::keys.pieces[p.side][p.type][square];
+            totals.add(p.side, p.type, square);
+        }
         pieces[row][column] = p;
+        if (bit & castling_squares)
+            refresh_state_key();
     }
 
     void set_piece_at(BoardPosition pos, Piece p = {}) {
         set_piece_at(pos.row, pos.column, p);
     }
 
+    /*
+     * Piece ids are handed out from 1 and a full set only uses 32, so they fit in moved_pieces.
+     * Ids past 63 can only come from setting up boards by hand, those fall back to the move history.
+     */
     [[nodiscard]] bool moved(const Piece& p) const {
+        if (p.id >= 0 && p.id < 64)
+            return moved_pieces & (uint64_t{1} << p.id);
         return std::any_of(moves.begin(), moves.end(), [&](const Move& move) {
             return p.id == move.piece_id;
         });
     }
 
+    /*
+     * A side can still castle on a wing while its king and that wing's rook are on their starting squares and haven't moved.
+     * Doesn't look at whether the squares between them are free or attacked.
+     */
+    [[nodiscard]] int castling_rights() const {
+        int rights = 0;
+        for (auto side: {White, Black}) {
+            int row = side == White ? 7 : 0;
+            auto king = pieces[row][4];
+            if (king.type != King || king.side != side || moved(king))
+                continue;
+            auto king_rook = pieces[row][7];
+            if (king_rook.type == Rook && king_rook.side == side && !moved(king_rook))
+                rights |= side == White ? WhiteKingSide : BlackKingSide;
+            auto queen_rook = pieces[row][0];
+            if (queen_rook.type == Rook && queen_rook.side == side && !moved(queen_rook))
+                rights |= side == White ? WhiteQueenSide : BlackQueenSide;
+        }
+        return rights;
+    }
+
     [[nodiscard]] BoardLine line_of_sight(BoardPosition, int, int) const;
 
     [[nodiscard]] std::vector<BoardPosition> get_threatened_positions(BoardPosition) const;
@@ -119,26 +206,55 @@ struct Board {
     [[nodiscard]] bool can_move(Side) const;
 
     [[nodiscard]] std::vector<Move> possible_moves(BoardPosition) const;
+    [[nodiscard]] MoveList legal_moves(Side, Bitboard from = ~Bitboard{0}) const;
+
+    /*
+     * The same, into a list the caller keeps, replacing what it held.
+     */
+    void legal_moves(Side, MoveList& list, Bitboard from = ~Bitboard{0}) const;
+
+    [[nodiscard]] int en_passant_square() const;
+
+    /*
+     * Turns a packed move back into the full move, with the id and type of the piece standing on its starting square.
+     */
+    [[nodiscard]] Move unpack_move(PackedMove packed) const {
+        auto move = packed.unpack();
+        auto piece = get_piece_at(move.current);
+        move.piece_id = piece.id;
+        move.piece_type = piece.type;
+        return move;
+    }
 
     [[nodiscard]] Side last_turn_color() const {
         if (moves.empty())
-            return Black;
+            return first_turn == White ? Black : White;
         return get_piece_at(moves.back().next).side;
     }
 
+    [[nodiscard]] Side side_to_move() const {
+        return last_turn_color() == White ? Black : White;
+    }
+
     [[nodiscard]] std::vector<BoardPosition> get_pieces(Side color) const {
         std::vector<BoardPosition> pieces;
-        for (int y = 0; y < 8; y++) {
-            for (int x = 0; x < 8; x++) {
-                auto piece = get_piece_at(y, x);
-                if (piece.type == None || piece.side != color)
-                    continue;
-                pieces.push_back({y, x});
-            }
-        }
+        auto board = side_boards[color];
+        pieces.reserve(count_squares(board));
+        while (board)
+            pieces.push_back(square_position(pop_first_square(board)));
         return pieces;
     }
 
+    [[nodiscard]] Bitboard occupied() const {
+        return side_boards[White] | side_boards[Black];
+    }
+
+    [[nodiscard]] Bitboard get_piece_board(Pieces type, Side color) const {
+        return piece_boards[type] & side_boards[color];
+    }
+
+    [[nodiscard]] Bitboard attackers_to(int square, Bitboard occupancy) const;
+
     [[nodiscard]] bool castled(Side color) const {
         return _castled[color];
     }
@@ -148,10 +264,90 @@ struct Board {
     std::array<std::array<Piece, 8>, 8> pieces;
     int piece_id;
     Pieces last_piece_taken;
+
+    /*
+     * The same position as pieces, as one set of squares per piece type and one per side.
+     * Kept in sync by set_piece_at, which every change to the board goes through.
+     */
+    std::array<Bitboard, 7> piece_boards;
+    std::array<Bitboard, 3> side_boards;
+
+    /*
+     * Bit n is set once the piece with id n has moved, Board::move keeps it current.
+     */
+    uint64_t moved_pieces;
+
+    /*
+     * The side that makes the first move in moves, White unless the board was loaded from a FEN.
+     */
+    Side first_turn;
+
+    /*
+     * The Zobrist key of the position, kept up to date by set_piece_at and move.
+     * It should always equal compute_key().
+     */
+    uint64_t key;
+
+    [[nodiscard]] uint64_t compute_key() const {
+        uint64_t k = 0;
+        for (int side = White; side <= Black; side++) {
+            for (int type = Pawn; type <= King; type++) {
+                auto board = piece_boards[type] & side_boards[side];
+                while (board)
+                    k ^= zobrist::keys.pieces[side][type][pop_first_square(board)];
+            }
+        }
+        return k ^ compute_state_key();
+    }
+
+    /*
+     * Material, piece-square sums and game phase, kept up to date by set_piece_at alongside key
+     * so scorers can read them instead of walking the board. They should always equal compute_totals().
+     */
+    evaluation::Totals totals;
+
+    [[nodiscard]] evaluation::Totals compute_totals() const {
+        evaluation::Totals t;
+        for (int side = White; side <= Black; side++) {
+            for (int type = Pawn; type <= King; type++) {
+                auto board = piece_boards[type] & side_boards[side];
+                while (board)
+                    t.add((Side)side, (Pieces)type, pop_first_square(board));
+            }
+        }
+        return t;
+    }
 private:
+    /*
+     * Castling rights can only change when a piece lands on or leaves one of these squares.
+     */
+    static constexpr Bitboard castling_squares = square_bit(0) | square_bit(4) | square_bit(7) | square_bit(56) | square_bit(60) | square_bit(63);
+
+    /*
+     * The part of the key that isn't piece placement: the castling rights, the en passant file and the side to move.
+     * These are worked out from the rest of the board, so the part already in key is kept in state_key and swapped when they may have changed.
+     */
+    uint64_t state_key;
+
+    [[nodiscard]] uint64_t compute_state_key() const {
+        uint64_t k = zobrist::keys.castling[castling_rights()];
+        int en_passant = en_passant_square();
+        if (en_passant >= 0)
+            k ^= zobrist::keys.en_passant[en_passant % 8];
+        if (side_to_move() == Black)
+            k ^= zobrist::keys.black_to_move;
+        return k;
+    }
+
+    void refresh_state_key() {
+        key ^= state_key;
+        state_key = compute_state_key();
+        key ^= state_key;
+    }
+
     std::array<bool, 3> _castled;
 
-    static std::vector<BoardPosition> merge_lines(const std::vector<BoardLine>&);
+    static void append_rays(std::vector<BoardPosition>&, BoardPosition, Bitboard, const std::array<std::array<int, 2>, 4>&);
 };
 
 #endif //CHESS_BOARD_H
@@ -0,0 +1,196 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#ifndef CHESS_EVALUATION_H
+#define CHESS_EVALUATION_H
+
+#include <algorithm>
+#include <array>
+
+#include "../data_types.h"
+
+/*
+ * Piece values and piece-square tables, fixed at compile time so Board can keep their totals as pieces come and go.
+ * Piece values are on the scale the scorers have always used, a pawn is 1.
+ * The piece-square tables are in hundredths of a pawn, with one table for the middlegame and one for the endgame,
+ * blended by how much of the non-pawn material is still on the board.
+ */
+namespace evaluation {
+    constexpr std::array<int, 7> piece_values = {
+            0,   // None
+            1,   // Pawn
+            10,  // Rook
+            5,   // Bishop
+            5,   // Knight
+            25,  // Queen
+            100, // King
+    };
+
+    /*
+     * How much each piece counts toward the game phase, a full set of knights, bishops, rooks and queens is MAX_PHASE.
+     */
+    constexpr std::array<int, 7> phase_weights = {0, 0, 2, 1, 1, 4, 0};
+    constexpr int MAX_PHASE = 24;
+
+    using Table = std::array<int, 64>;
+
+    /*
+     * Tables are laid out as the board is printed from White's side, row 0 being the eighth rank.
+     */
+    constexpr Table pawn_middlegame = {
+             0,   0,   0,   0,   0,   0,   0,   0,
+            50,  50,  50,  50,  50,  50,  50,  50,
+            10,  10,  20,  30,  30,  20,  10,  10,
+             5,   5,  10,  25,  25,  10,   5,   5,
+             0,   0,   0,  20,  20,   0,   0,   0,
+             5,  -5, -10,   0,   0, -10,  -5,   5,
+             5,  10,  10, -20, -20,  10,  10,   5,
+             0,   0,   0,   0,   0,   0,   0,   0,
+    };
+
+    constexpr Table pawn_endgame = {
+             0,   0,   0,   0,   0,   0,   0,   0,
+            80,  80,  80,  80,  80,  80,  80,  80,
+            50,  50,  50,  50,  50,  50,  50,  50,
+            30,  30,  30,  30,  30,  30,  30,  30,
+            20,  20,  20,  20,  20,  20,  20,  20,
+            10,  10,  10,  10,  10,  10,  10,  10,
+            10,  10,  10,  10,  10,  10,  10,  10,
+             0,   0,   0,   0,   0,   0,   0,   0,
+    };
+
+    constexpr Table knight = {
+            -50, -40, -30, -30, -30, -30, -40, -50,
+            -40, -20,   0,   0,   0,   0, -20, -40,
+            -30,   0,  10,  15,  15,  10,   0, -30,
+            -30,   5,  15,  20,  20,  15,   5, -30,
+            -30,   0,  15,  20,  20,  15,   0, -30,
+            -30,   5,  10,  15,  15,  10,   5, -30,
+            -40, -20,   0,   5,   5,   0, -20, -40,
+            -50, -40, -30, -30, -30, -30, -40, -50,
+    };
+
+    constexpr Table bishop = {
+            -20, -10, -10, -10, -10, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,  10,  10,   5,   0, -10,
+            -10,   5,   5,  10,  10,   5,   5, -10,
+            -10,   0,  10,  10,  10,  10,   0, -10,
+            -10,  10,  10,  10,  10,  10,  10, -10,
+            -10,   5,   0,   0,   0,   0,   5, -10,
+            -20, -10, -10, -10, -10, -10, -10, -20,
+    };
+
+    constexpr Table rook = {
+             0,   0,   0,   0,   0,   0,   0,   0,
+             5,  10,  10,  10,  10,  10,  10,   5,
+            -5,   0,   0,   0,   0,   0,   0,  -5,
+            -5,   0,   0,   0,   0,   0,   0,  -5,
+            -5,   0,   0,   0,   0,   0,   0,  -5,
+            -5,   0,   0,   0,   0,   0,   0,  -5,
+            -5,   0,   0,   0,   0,   0,   0,  -5,
+             0,   0,   0,   5,   5,   0,   0,   0,
+    };
+
+    constexpr Table queen = {
+            -20, -10, -10,  -5,  -5, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,   5,   5,   5,   0, -10,
+             -5,   0,   5,   5,   5,   5,   0,  -5,
+              0,   0,   5,   5,   5,   5,   0,  -5,
+            -10,   5,   5,   5,   5,   5,   0, -10,
+            -10,   0,   5,   0,   0,   0,   0, -10,
+            -20, -10, -10,  -5,  -5, -10, -10, -20,
+    };
+
+    /*
+     * The king hides behind its pawns while there are pieces to attack it, and comes to the center once they are traded off.
+     */
+    constexpr Table king_middlegame = {
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -20, -30, -30, -40, -40, -30, -30, -20,
+            -10, -20, -20, -20, -20, -20, -20, -10,
+             20,  20,   0,   0,   0,   0,  20,  20,
+             20,  30,  10,   0,   0,  10,  30,  20,
+    };
+
+    constexpr Table king_endgame = {
+            -50, -40, -30, -20, -20, -30, -40, -50,
+            -30, -20, -10,   0,   0, -10, -20, -30,
+            -30, -10,  20,  30,  30,  20, -10, -30,
+            -30, -10,  30,  40,  40,  30, -10, -30,
+            -30, -10,  30,  40,  40,  30, -10, -30,
+            -30, -10,  20,  30,  30,  20, -10, -30,
+            -30, -30,   0,   0,   0,   0, -30, -30,
+            -50, -30, -30, -30, -30, -30, -30, -50,
+    };
+
+    struct Tables {
+        std::array<std::array<Table, 7>, 3> middlegame{};
+        std::array<std::array<Table, 7>, 3> endgame{};
+    };
+
+    /*
+     * Each side's tables indexed by square, Black's being White's flipped top to bottom.
+     */
+    [[nodiscard]] constexpr Tables generate() {
+        Tables tables;
+        std::array<Table, 7> middlegame = {Table{}, pawn_middlegame, rook, bishop, knight, queen, king_middlegame};
+        std::array<Table, 7> endgame = {Table{}, pawn_endgame, rook, bishop, knight, queen, king_endgame};
+        for (int type = Pawn; type <= King; type++) {
+            for (int square = 0; square < 64; square++) {
+                tables.middlegame[White][type][square] = middlegame[type][square];
+                tables.endgame[White][type][square] = endgame[type][square];
+                tables.middlegame[Black][type][square] = middlegame[type][square ^ 56];
+                tables.endgame[Black][type][square] = endgame[type][square ^ 56];
+            }
+        }
+        return tables;
+    }
+
+    constexpr Tables tables = generate();
+
+    /*
+     * Each side's material and piece-square sums and the phase of the game, which Board keeps up to date as pieces are set.
+     */
+    struct Totals {
+        std::array<int, 3> material{};
+        std::array<int, 3> middlegame{};
+        std::array<int, 3> endgame{};
+        int phase = 0;
+
+        constexpr void add(Side side, Pieces type, int square) {
+            material[side] += piece_values[type];
+            middlegame[side] += tables.middlegame[side][type][square];
+            endgame[side] += tables.endgame[side][type][square];
+            phase += phase_weights[type];
+        }
+
+        constexpr void remove(Side side, Pieces type, int square) {
+            material[side] -= piece_values[type];
+            middlegame[side] -= tables.middlegame[side][type][square];
+            endgame[side] -= tables.endgame[side][type][square];
+            phase -= phase_weights[type];
+        }
+
+        /*
+         * The piece-square score from side's point of view, in hundredths of a pawn.
+         * Promotions can push the phase past MAX_PHASE, that still counts as the middlegame.
+         */
+        [[nodiscard]] constexpr int positional(Side side) const {
+            Side enemy = side == White ? Black : White;
+            int weight = std::min(phase, MAX_PHASE);
+            int opening = middlegame[side] - middlegame[enemy];
+            int ending = endgame[side] - endgame[enemy];
+            return (opening * weight + ending * (MAX_PHASE - weight)) / MAX_PHASE;
+        }
+
+        constexpr bool operator==(const Totals&) const = default;
+    };
+}
+
+#endif //CHESS_EVALUATION_H
@@ -0,0 +1,129 @@
+//
+// Created by Chris Luttio on 1/14/22.
+//
+
+#include "perft.h"
+
+#include <thread>
+
+const std::array<PerftPosition, 6> perft_positions {{
+    {"start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            {48, 2039, 97862, 4085603, 193690690, 0}},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            {44, 1486, 62379, 2103487, 89941194, 0}},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+            {46, 2079, 89890, 3894594, 164075551, 0}},
+}};
+
+/*
+ * The last ply isn't played, the number of legal moves is the number of leaves under it.
+ */
+uint64_t perft(Board& board, int depth) {
+    if (depth <= 0)
+        return 1;
+    auto moves = board.legal_moves(board.side_to_move());
+    if (depth == 1)
+        return moves.size();
+    uint64_t nodes = 0;
+    for (const auto& move: moves) {
+        auto undo = board.make_move(move);
+        nodes += perft(board, depth - 1);
+        board.unmake_move(undo);
+    }
+    return nodes;
+}
+
+std::vector<std::pair<Move, uint64_t>> perft_divide(Board& board, int depth) {
+    std::vector<std::pair<Move, uint64_t>> counts;
+    if (depth <= 0)
+        return counts;
+    auto moves = board.legal_moves(board.side_to_move());
+    counts.reserve(moves.size());
+    for (const auto& move: moves) {
+        auto undo = board.make_move(move);
+        counts.emplace_back(move, perft(board, depth - 1));
+        board.unmake_move(undo);
+    }
+    return counts;
+}
+
+PerftTable::PerftTable(size_t megabytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+        count *= 2;
+    entry_count = count;
+    entries = std::make_unique<Entry[]>(count);
+}
+
+/*
+ * Counts go in the top 56 bits and the depth in the bottom 8.
+ */
+bool PerftTable::probe(uint64_t key, int depth, uint64_t& nodes) const {
+    const auto& entry = entries[key & (entry_count - 1)];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || (int)(data & 0xff) != depth)
+        return false;
+    nodes = data >> 8;
+    return true;
+}
+
+void PerftTable::store(uint64_t key, int depth, uint64_t nodes) {
+    auto& entry = entries[key & (entry_count - 1)];
+    uint64_t data = (nodes << 8) | (uint64_t)depth;
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+static uint64_t perft_hashed(Board& board, int depth, PerftTable& table) {
+    if (depth <= 1)
+        return perft(board, depth);
+    uint64_t key = board.key;
+    uint64_t nodes = 0;
+    if (table.probe(key, depth, nodes))
+        return nodes;
+    auto moves = board.legal_moves(board.side_to_move());
+    for (const auto& move: moves) {
+        auto undo = board.make_move(move);
+        nodes += perft_hashed(board, depth - 1, table);
+        board.unmake_move(undo);
+    }
+    table.store(key, depth, nodes);
+    return nodes;
+}
+
+uint64_t perft_parallel(const Board& board, int depth, int threads, PerftTable& table) {
+    if (depth <= 1) {
+        Board scratch = board;
+        return perft(scratch, depth);
+    }
+
+    auto moves = board.legal_moves(board.side_to_move());
+    std::atomic<size_t> next{0};
+    std::atomic<uint64_t> total{0};
+
+    auto work = [&]() {
+        Board scratch = board;
+        uint64_t nodes = 0;
+        for (size_t i = next++; i < moves.size(); i = next++) {
+            auto undo = scratch.make_move(moves[i]);
+            nodes += perft_hashed(scratch, depth - 1, table);
+            scratch.unmake_move(undo);
+        }
+        total += nodes;
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back(work);
+    work();
+    for (auto& worker: workers)
+        worker.join();
+    return total;
+}
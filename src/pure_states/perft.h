@@ -0,0 +1,75 @@
+//
+// Created by Chris Luttio on 1/14/22.
+//
+
+#ifndef CHESS_PERFT_H
+#define CHESS_PERFT_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+
+/*
+ * Counts the leaf nodes of the legal move tree to a depth, for the side to move.
+ * The counts for well known positions are published, so any difference points to a bug in move generation.
+ * The board is played on in place and left as it was found.
+ */
+uint64_t perft(Board& board, int depth);
+
+/*
+ * The perft count below each root move, in the order the moves are generated.
+ */
+std::vector<std::pair<Move, uint64_t>> perft_divide(Board& board, int depth);
+
+/*
+ * Perft counts by Zobrist key and depth, shared by every thread of a parallel perft without locks.
+ * An entry is two words, the count packed with the depth, and that word XORed with the position's key.
+ * Threads can write the two words of an entry at the same time and leave them mismatched,
+ * which the XOR check turns into a miss instead of a wrong count.
+ * New counts always replace what is in their slot.
+ */
+struct PerftTable {
+    explicit PerftTable(size_t megabytes);
+
+    [[nodiscard]] bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+    void store(uint64_t key, int depth, uint64_t nodes);
+
+    [[nodiscard]] size_t size() const {
+        return entry_count;
+    }
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    size_t entry_count;
+};
+
+/*
+ * Perft with the root moves shared out between threads, each taking the next unclaimed move when it finishes one.
+ * Subtrees already counted by any thread are read from the table instead of being walked again.
+ */
+uint64_t perft_parallel(const Board& board, int depth, int threads, PerftTable& table);
+
+/*
+ * The standard perft test positions, with their published node counts by depth starting at 1.
+ * Counts that are too slow to check are left as 0.
+ */
+struct PerftPosition {
+    const char* name;
+    const char* fen;
+    std::array<uint64_t, 6> nodes;
+};
+
+extern const std::array<PerftPosition, 6> perft_positions;
+
+#endif //CHESS_PERFT_H
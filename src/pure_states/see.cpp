@@ -0,0 +1,97 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "see.h"
+
+#include <array>
+
+#include "utils.h"
+
+static const std::array<Pieces, 6> cheapest_first {Pawn, Knight, Bishop, Rook, Queen, King};
+
+/*
+ * Finds side's least valuable piece in attackers, returns its square or -1.
+ */
+static int least_valuable(const Board& board, Bitboard attackers, Side side, Pieces& type) {
+    for (auto piece: cheapest_first) {
+        auto found = attackers & board.get_piece_board(piece, side);
+        if (found) {
+            type = piece;
+            return first_square(found);
+        }
+    }
+    return -1;
+}
+
+int static_exchange(const Board& board, const Move& move) {
+    int target = square_index(move.next);
+    auto mover = board.get_piece_at(move.current);
+    Bitboard occupancy = board.occupied() & ~square_bit(move.current);
+
+    std::array<int, 34> gain{};
+    if (move.type == Pawn_EnPassant) {
+        gain[0] = get_piece_value(Pawn);
+        occupancy &= ~square_bit(BoardPosition{move.current.row, move.next.column});
+    } else {
+        auto captured = board.get_piece_at(move.next);
+        gain[0] = captured.type == None ? 0 : get_piece_value(captured.type);
+    }
+
+    Pieces on_square = mover.type;
+    if (move.type == Pawn_Promotion) {
+        on_square = move.promotion;
+        gain[0] += get_piece_value(move.promotion) - get_piece_value(Pawn);
+    }
+
+    Side side = mover.side == White ? Black : White;
+    int depth = 0;
+    while (depth + 1 < (int)gain.size()) {
+        auto attackers = board.attackers_to(target, occupancy) & occupancy;
+        Pieces type = None;
+        int from = least_valuable(board, attackers, side, type);
+        if (from < 0)
+            break;
+        // A king can't take a piece that is still defended.
+        if (type == King && (board.attackers_to(target, occupancy & ~square_bit(from)) & occupancy & board.side_boards[side == White ? Black : White]))
+            break;
+        depth++;
+        // What this side gets if it takes the piece on the square and the exchange stops there.
+        gain[depth] = get_piece_value(on_square) - gain[depth - 1];
+        if (std::max(-gain[depth - 1], gain[depth]) < 0)
+            break;
+        occupancy &= ~square_bit(from);
+        on_square = type;
+        side = side == White ? Black : White;
+    }
+
+    // Going backwards, each side either takes or stops, whichever is better for it.
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+std::vector<Piece> exchange_sequence(const Board& board, BoardPosition position) {
+    std::vector<Piece> pieces;
+    auto piece = board.get_piece_at(position);
+    if (piece.type == None)
+        return pieces;
+    pieces.push_back(piece);
+
+    int target = square_index(position);
+    Bitboard occupancy = board.occupied() & ~square_bit(target);
+    Side side = piece.side == White ? Black : White;
+    while (true) {
+        auto attackers = board.attackers_to(target, occupancy) & occupancy;
+        Pieces type = None;
+        int from = least_valuable(board, attackers, side, type);
+        if (from < 0)
+            break;
+        pieces.push_back(board.get_piece_at(square_position(from)));
+        occupancy &= ~square_bit(from);
+        side = side == White ? Black : White;
+    }
+    return pieces;
+}
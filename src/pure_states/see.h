@@ -0,0 +1,28 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#ifndef CHESS_SEE_H
+#define CHESS_SEE_H
+
+#include <vector>
+
+#include "board.h"
+
+/*
+ * Static exchange evaluation: what a capture wins or loses once every piece that can join in has recaptured on the square,
+ * without searching. Each side takes with its least valuable piece first and may stop when going on would lose more.
+ * Sliders lined up behind a piece that captures (x-rays) join in once it has gone.
+ * Values are from get_piece_value, from the point of view of the side making the move.
+ * Pins are ignored.
+ */
+[[nodiscard]] int static_exchange(const Board& board, const Move& move);
+
+/*
+ * The pieces that would take part in an exchange on a square, starting with the piece on it.
+ * Sides alternate, each capturing with its least valuable piece, until one runs out of pieces that can reach the square.
+ * Unlike static_exchange, neither side ever stops early.
+ */
+[[nodiscard]] std::vector<Piece> exchange_sequence(const Board& board, BoardPosition position);
+
+#endif //CHESS_SEE_H
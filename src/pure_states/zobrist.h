@@ -0,0 +1,55 @@
+//
+// Created by Chris Luttio on 1/15/22.
+//
+
+#ifndef CHESS_ZOBRIST_H
+#define CHESS_ZOBRIST_H
+
+#include <array>
+#include <cstdint>
+
+#include "../data_types.h"
+
+/*
+ * Random numbers for Zobrist keys, one for each piece on each square, one for Black to move,
+ * one for each set of castling rights and one for each file an en passant capture can land on.
+ * A position's key is all the numbers that apply XORed together, so a move only has to XOR out what it changes and XOR in the rest.
+ * The numbers are fixed at compile time so keys are the same on every run.
+ */
+namespace zobrist {
+    [[nodiscard]] constexpr uint64_t split_mix(uint64_t& state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    struct Keys {
+        std::array<std::array<std::array<uint64_t, 64>, 7>, 3> pieces{};
+        std::array<uint64_t, 16> castling{};
+        std::array<uint64_t, 8> en_passant{};
+        uint64_t black_to_move{};
+    };
+
+    /*
+     * Empty squares and no castling rights have no number, so an empty board with White to move has the key 0.
+     */
+    [[nodiscard]] constexpr Keys generate() {
+        Keys keys;
+        uint64_t state = 0x2545f4914f6cdd1d;
+        for (int side = White; side <= Black; side++)
+            for (int type = Pawn; type <= King; type++)
+                for (int square = 0; square < 64; square++)
+                    keys.pieces[side][type][square] = split_mix(state);
+        for (int rights = 1; rights < 16; rights++)
+            keys.castling[rights] = split_mix(state);
+        for (int file = 0; file < 8; file++)
+            keys.en_passant[file] = split_mix(state);
+        keys.black_to_move = split_mix(state);
+        return keys;
+    }
+
+    constexpr Keys keys = generate();
+}
+
+#endif //CHESS_ZOBRIST_H
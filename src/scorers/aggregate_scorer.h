@@ -5,6 +5,8 @@
 #ifndef CHESS_AGGREGATE_SCORER_H
 #define CHESS_AGGREGATE_SCORER_H
 
+#include <memory>
+
 #include "scorer.h"
 
 #include "development_scorer.h"
@@ -7,14 +7,11 @@
 
 #include "scorer.h"
 #include "utils.h"
+#include "pure_states/see.h"
 
 struct ControlScorer: Scorer {
     [[nodiscard]] int score(const Board &board, Side side) const override {
         int value = 0;
-        auto white = board.get_pieces(White);
-        auto black = board.get_pieces(Black);
-        auto our_pieces = side == White ? white : black;
-        auto enemy_s_pieces = side == White ? black : white;
         auto our_turn = board.last_turn_color() != side;
         /*
          * Look at each of the enemy's pieces, if we are attacking them, that is good.
@@ -22,8 +19,8 @@ struct ControlScorer: Scorer {
          * If we are attacking them well, then that's a doubly good position.
          */
         if (our_turn) {
-            for (const auto& piece: enemy_s_pieces) {
-                auto score = score_take(board, piece, side, white, black);
+            for (const auto& piece: board.get_pieces(side == White ? Black : White)) {
+                auto score = score_take(board, piece, side);
                 if (score > 0) {
                     value += score;
                 }
@@ -34,8 +31,8 @@ struct ControlScorer: Scorer {
          * Being attacked is bad, it should be avoided. But if we are attacked, how good is our defence?
          * Being attacked and having poor defence is doubly bad. Being attacked, but having good defence is neutral.
          */
-        for (const auto& piece: our_pieces) {
-            auto score = score_take(board, piece, side, white, black);
+        for (const auto& piece: board.get_pieces(side)) {
+            auto score = score_take(board, piece, side);
             if (score < 0) {
                 value += score;
             }
@@ -55,41 +52,13 @@ struct ControlScorer: Scorer {
     /*
      * Given a position with a piece, how well attacked or defended is it? If the side is equal to the piece's side, how well defended is this side's piece?
      * If not, how well attacked?
+     * The attackers and defenders, x-rays included, come from one pass over the square's attackers in exchange_sequence.
      */
-    [[nodiscard]] static int score_take(const Board& board, BoardPosition position, Side side, const std::vector<BoardPosition>& white, const std::vector<BoardPosition>& black) {
-        auto piece = board.get_piece_at(position);
-        auto color = piece.side;
-
-        auto possible_attackers = color == White ? black : white;
-        auto possible_defenders = color == White ? white : black;
-
-        std::vector<Piece> attackers, defenders;
-
-        for (const auto& pos: possible_attackers) {
-            Move move{pos, position};
-            if (board.legal(move)) {
-                attackers.push_back(board.get_piece_at(pos));
-            }
-        }
-        for (const auto& pos: possible_defenders) {
-            Move move{pos, position};
-            if (board.can_defend(move)) {
-                defenders.push_back(board.get_piece_at(pos));
-            }
-        }
-
-        auto sort_by_value = [&](const Piece& a, const Piece& b) {
-            auto pa = get_piece_value(a.type);
-            auto pb = get_piece_value(b.type);
-            return pa < pb;
-        };
-        std::sort(attackers.begin(), attackers.end(), sort_by_value);
-        std::sort(defenders.begin(), defenders.end(), sort_by_value);
-
-        defenders.insert(defenders.begin(), piece);
-        auto merged = zip(defenders, attackers);
-
-        return compute_composite_score(merged) * (side == color ? 1 : -1);
+    [[nodiscard]] static int score_take(const Board& board, BoardPosition position, Side side) {
+        auto pieces = exchange_sequence(board, position);
+        if (pieces.empty())
+            return 0;
+        return compute_composite_score(pieces) * (side == pieces[0].side ? 1 : -1);
     }
 
     [[nodiscard]] static int compute_composite_score(const std::vector<Piece>& pieces) {
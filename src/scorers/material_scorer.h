@@ -8,19 +8,13 @@
 #include "scorer.h"
 #include "utils.h"
 
+/*
+ * Reads the material totals Board keeps as pieces are set, so it doesn't have to look at the squares.
+ */
 struct MaterialScorer: Scorer {
     [[nodiscard]] int score(const Board &board, Side color) const override {
-        int piece_score = 0;
-        for (int y = 0; y < 8; y++) {
-            for (int x = 0; x < 8; x++) {
-                auto piece = board.get_piece_at(y, x);
-                if (piece.type == None)
-                    continue;
-                int side = (piece.side == color ? 1 : -1);
-                piece_score += side * get_piece_value(piece.type);
-            }
-        }
-        return piece_score;
+        Side enemy = color == White ? Black : White;
+        return board.totals.material[color] - board.totals.material[enemy];
     }
 };
 
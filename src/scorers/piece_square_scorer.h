@@ -0,0 +1,21 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#ifndef CHESS_PIECE_SQUARE_SCORER_H
+#define CHESS_PIECE_SQUARE_SCORER_H
+
+#include "scorer.h"
+
+/*
+ * Scores where the pieces stand from the piece-square totals Board keeps, tapered from the middlegame tables
+ * to the endgame ones as pieces come off.
+ * The tables are in hundredths of a pawn and SmartAIPlayer weighs a pawn of material at 10, so this scores in tenths.
+ */
+struct PieceSquareScorer: Scorer {
+    [[nodiscard]] int score(const Board &board, Side side) const override {
+        return board.totals.positional(side) / 10;
+    }
+};
+
+#endif //CHESS_PIECE_SQUARE_SCORER_H
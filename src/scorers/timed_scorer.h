@@ -0,0 +1,43 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#ifndef CHESS_TIMED_SCORER_H
+#define CHESS_TIMED_SCORER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "scorer.h"
+
+/*
+ * Scores with another scorer, counting the calls and the time they take while timing is on.
+ * Reading the clock twice a call costs around a tenth of the scoring, so it's off until asked for.
+ * The counts are atomic since Lazy SMP's threads share the scorers, so the time is added up across threads.
+ */
+struct TimedScorer: Scorer {
+    TimedScorer(std::string name, std::shared_ptr<Scorer> scorer): name(std::move(name)), scorer(std::move(scorer)) {}
+
+    [[nodiscard]] int score(const Board &board, Side side) const override {
+        if (!timing.load(std::memory_order_relaxed))
+            return scorer->score(board, side);
+        auto start = std::chrono::steady_clock::now();
+        int value = scorer->score(board, side);
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        calls.fetch_add(1, std::memory_order_relaxed);
+        nanoseconds.fetch_add((uint64_t)elapsed.count(), std::memory_order_relaxed);
+        return value;
+    }
+
+    std::string name;
+    std::shared_ptr<Scorer> scorer;
+    std::atomic<bool> timing{false};
+    mutable std::atomic<uint64_t> calls{0};
+    mutable std::atomic<uint64_t> nanoseconds{0};
+};
+
+#endif //CHESS_TIMED_SCORER_H
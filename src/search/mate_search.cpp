@@ -0,0 +1,176 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "mate_search.h"
+
+#include <algorithm>
+
+MateResult MateSearch::solve(const Board& board, int moves, const std::atomic<bool>* stop) {
+    MateResult result;
+    searched = 0;
+    Board position = board;
+    for (int n = 1; n <= moves; n++) {
+        result.proof = prove(position, n, stop);
+        if (result.proof == Unproven)
+            break;
+        if (result.proof == Proven) {
+            result.moves = n;
+            uint32_t index = 0;
+            for (int ply = 0; nodes[index].expanded; ply++) {
+                int length = distance(index, ply);
+                const auto& node = nodes[index];
+                for (uint32_t child = node.first_child; child < node.first_child + node.children; child++) {
+                    if (nodes[child].proof == 0 && distance(child, ply + 1) + 1 == length) {
+                        index = child;
+                        break;
+                    }
+                }
+                Move move = position.unpack_move(nodes[index].move);
+                result.line.push_back(move);
+                position.move(move);
+            }
+            break;
+        }
+    }
+    result.nodes = searched;
+    return result;
+}
+
+Proof MateSearch::prove(Board& board, int moves, const std::atomic<bool>* stop) {
+    nodes.clear();
+    nodes.emplace_back();
+    initialize(nodes[0], board, 0, moves);
+
+    std::vector<uint32_t> path;
+    std::vector<MoveUndo> undos;
+    while (nodes[0].proof != 0 && nodes[0].disproof != 0) {
+        if (nodes.size() >= max_nodes || (stop && stop->load(std::memory_order_relaxed)))
+            return Unproven;
+
+        // Down to the most proving position: the least proof number where the mating side chooses, the least disproof number where the other does.
+        path.assign(1, 0);
+        uint32_t index = 0;
+        while (nodes[index].expanded) {
+            const auto& node = nodes[index];
+            bool mating = path.size() % 2 == 1;
+            uint32_t best = node.first_child;
+            for (uint32_t child = node.first_child + 1; child < node.first_child + node.children; child++) {
+                if (mating ? nodes[child].proof < nodes[best].proof : nodes[child].disproof < nodes[best].disproof)
+                    best = child;
+            }
+            undos.push_back(board.make_move(board.unpack_move(nodes[best].move)));
+            index = best;
+            path.push_back(index);
+        }
+
+        expand(board, index, (int)path.size() - 1, moves);
+        for (int ply = (int)path.size() - 2; ply >= 0; ply--)
+            update(path[ply], ply);
+
+        while (!undos.empty()) {
+            board.unmake_move(undos.back());
+            undos.pop_back();
+        }
+    }
+    return nodes[0].proof == 0 ? Proven : Disproven;
+}
+
+/*
+ * Before a position is expanded, its number of moves stands in for its children: the more replies the other side has,
+ * the harder it is to prove, and the more moves the mating side has, the harder it is to disprove.
+ */
+void MateSearch::initialize(Node& node, const Board& board, int ply, int moves) const {
+    Side side = board.side_to_move();
+    bool mating = ply % 2 == 0;
+    auto legal = board.legal_moves(side);
+    if (legal.empty()) {
+        bool mated = !mating && board.king_in_check(side);
+        node.proof = mated ? 0 : INFINITE_PROOF;
+        node.disproof = mated ? INFINITE_PROOF : 0;
+        return;
+    }
+    // Out of moves for the mating side.
+    if (ply >= 2 * moves - 1) {
+        node.proof = INFINITE_PROOF;
+        node.disproof = 0;
+        return;
+    }
+    node.proof = mating ? 1 : (uint32_t)legal.size();
+    node.disproof = mating ? (uint32_t)legal.size() : 1;
+}
+
+void MateSearch::expand(Board& board, uint32_t index, int ply, int moves) {
+    Side side = board.side_to_move();
+    Side enemy = side == White ? Black : White;
+    bool mating = ply % 2 == 0;
+    auto legal = board.legal_moves(side);
+    auto first = (uint32_t)nodes.size();
+    for (const auto& move: legal) {
+        auto undo = board.make_move(move);
+        if (!mating || !checks_only || board.king_in_check(enemy)) {
+            Node child;
+            child.move = PackedMove(move);
+            initialize(child, board, ply + 1, moves);
+            nodes.push_back(child);
+            searched++;
+        }
+        board.unmake_move(undo);
+    }
+    auto& node = nodes[index];
+    node.first_child = first;
+    node.children = (uint16_t)(nodes.size() - first);
+    node.expanded = true;
+    update(index, ply);
+}
+
+void MateSearch::update(uint32_t index, int ply) {
+    auto& node = nodes[index];
+    bool mating = ply % 2 == 0;
+    uint32_t least = INFINITE_PROOF, sum = 0;
+    for (uint32_t child = node.first_child; child < node.first_child + node.children; child++) {
+        uint32_t minimized = mating ? nodes[child].proof : nodes[child].disproof;
+        uint32_t summed = mating ? nodes[child].disproof : nodes[child].proof;
+        least = std::min(least, minimized);
+        sum = std::min(sum + summed, INFINITE_PROOF);
+    }
+    // With no children (no checks to give) there is nothing to prove it with.
+    if (node.children == 0)
+        sum = mating ? 0 : INFINITE_PROOF;
+    node.proof = mating ? least : sum;
+    node.disproof = mating ? sum : least;
+}
+
+int MateSearch::distance(uint32_t index, int ply) const {
+    const auto& node = nodes[index];
+    if (!node.expanded)
+        return 0;
+    bool mating = ply % 2 == 0;
+    int best = mating ? INFINITE_PROOF : 0;
+    for (uint32_t child = node.first_child; child < node.first_child + node.children; child++) {
+        if (nodes[child].proof != 0)
+            continue;
+        int length = distance(child, ply + 1) + 1;
+        best = mating ? std::min(best, length) : std::max(best, length);
+    }
+    return best;
+}
+
+bool MateSearch::king_exposed(const Board& board) {
+    Side side = board.side_to_move();
+    Side enemy = side == White ? Black : White;
+    Bitboard king = board.get_piece_board(King, enemy);
+    if (!king)
+        return false;
+    Bitboard own = 0;
+    for (auto type: {Pawn, Knight, Bishop, Rook, Queen, King})
+        own |= board.get_piece_board(type, side);
+    Bitboard around = king_attacks[first_square(king)];
+    Bitboard occupied = board.occupied();
+    int attacked = 0;
+    while (around) {
+        if (board.attackers_to(pop_first_square(around), occupied) & own)
+            attacked++;
+    }
+    return attacked >= 2;
+}
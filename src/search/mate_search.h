@@ -0,0 +1,109 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#ifndef CHESS_MATE_SEARCH_H
+#define CHESS_MATE_SEARCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "data_types.h"
+#include "pure_states/board.h"
+
+/*
+ * Whether a search proved what it set out to, showed it can't be done, or ran out of nodes (or was stopped) first.
+ */
+enum Proof {
+    Unproven,
+    Proven,
+    Disproven
+};
+
+struct MateResult {
+    Proof proof{Unproven};
+
+    /*
+     * When proven, how many moves the side to move needs to mate, counting the mating move.
+     */
+    int moves{0};
+
+    /*
+     * The mating line, with the defence that holds out longest.
+     */
+    std::vector<Move> line;
+
+    uint64_t nodes{0};
+};
+
+/*
+ * Proof-number search for a forced mate by the side to move, apart from the evaluation-driven Search.
+ *
+ * The tree is grown one position at a time, always from the one that would do the most to settle the question:
+ * each position has a proof number, how many positions at least still have to be shown mated to prove it,
+ * and a disproof number, how many have to be shown to escape to disprove it. Where the side mating is to move one move is enough,
+ * so a position's proof number is its children's least and its disproof number their sum; where the other side is to move it's the other way round.
+ * Forcing lines, checks with few replies, have small proof numbers, so they are looked at first, without a fixed depth or any scoring.
+ *
+ * Each search is limited to a number of moves. solve searches for a mate in 1, then 2 and so on, so the first one proven is the shortest.
+ */
+struct MateSearch {
+    /*
+     * The most positions kept in the tree for one number of moves, a search that needs more is left unproven.
+     */
+    size_t max_nodes{1 << 20};
+
+    /*
+     * Only look at checks for the side mating. Much quicker, but quiet moves that set up a mate are missed
+     * and a disproof only means there is no mate by checks alone.
+     */
+    bool checks_only{false};
+
+    /*
+     * The shortest forced mate in at most moves moves for the side to move, or a proof there is none.
+     * Stalemate counts as an escape. Repetitions and the fifty move rule aren't detected, Board keeps no halfmove clock,
+     * so a mate may be reported that the other side could draw out of.
+     */
+    MateResult solve(const Board& board, int moves, const std::atomic<bool>* stop = nullptr);
+
+    /*
+     * Whether at least two of the squares around the other side's king are attacked by the side to move, worth looking for a mate.
+     */
+    [[nodiscard]] static bool king_exposed(const Board& board);
+
+private:
+    static constexpr uint32_t INFINITE_PROOF = 1u << 30;
+
+    struct Node {
+        PackedMove move;
+        uint32_t proof{1};
+        uint32_t disproof{1};
+        uint32_t first_child{0};
+        uint16_t children{0};
+        bool expanded{false};
+    };
+
+    /*
+     * Whether there's a mate in moves moves, leaving the tree behind for the line.
+     */
+    Proof prove(Board& board, int moves, const std::atomic<bool>* stop);
+
+    /*
+     * Proof and disproof numbers for a position that was just reached, ply plies from the root.
+     */
+    void initialize(Node& node, const Board& board, int ply, int moves) const;
+    void expand(Board& board, uint32_t index, int ply, int moves);
+    void update(uint32_t index, int ply);
+
+    /*
+     * Plies to mate from a proven node within the tree, the mating side taking the quickest mate and the other side putting it off longest.
+     */
+    [[nodiscard]] int distance(uint32_t index, int ply) const;
+
+    std::vector<Node> nodes;
+    uint64_t searched{0};
+};
+
+#endif //CHESS_MATE_SEARCH_H
@@ -0,0 +1,112 @@
+//
+// Created by Chris Luttio on 1/16/22.
+//
+
+#ifndef CHESS_MOVE_ORDERING_H
+#define CHESS_MOVE_ORDERING_H
+
+#include <array>
+#include <cstring>
+
+#include "data_types.h"
+#include "utils.h"
+#include "pure_states/board.h"
+
+/*
+ * Puts the moves most likely to cause a cutoff first:
+ *  the move the transposition table or the last iteration found best,
+ *  then captures and promotions, most valuable victim first and among those least valuable attacker first,
+ *  then the two quiet moves that last caused a cutoff at the same ply (the killers),
+ *  then the rest of the quiet moves by how often they have caused cutoffs anywhere (the history).
+ */
+struct MoveOrdering {
+    static constexpr int MAX_PLY = 128;
+
+    MoveOrdering() {
+        clear();
+    }
+
+    void clear() {
+        for (auto& ply: killers)
+            ply = {};
+        std::memset(history.data(), 0, sizeof(history));
+    }
+
+    [[nodiscard]] static bool is_capture(const Board& board, const Move& move) {
+        return move.type == Pawn_EnPassant || board.get_piece_at(move.next).type != None;
+    }
+
+    [[nodiscard]] static bool is_quiet(const Board& board, const Move& move) {
+        return !is_capture(board, move) && move.type != Pawn_Promotion;
+    }
+
+    /*
+     * Gives every move in moves a score, higher goes first.
+     */
+    void score(const Board& board, const MoveList& moves, PackedMove best, int ply, std::array<int, MoveList::capacity>& scores) const {
+        for (size_t i = 0; i < moves.size(); i++) {
+            const auto& move = moves[i];
+            PackedMove packed(move);
+            if (packed == best) {
+                scores[i] = BEST_MOVE;
+            } else if (is_capture(board, move) || move.type == Pawn_Promotion) {
+                Pieces victim = move.type == Pawn_EnPassant ? Pawn : board.get_piece_at(move.next).type;
+                int value = victim == None ? 0 : get_piece_value(victim) * 100;
+                if (move.type == Pawn_Promotion)
+                    value += get_piece_value(move.promotion) * 100;
+                scores[i] = CAPTURE + value - get_piece_value(move.piece_type);
+            } else if (ply < MAX_PLY && packed == killers[ply][0]) {
+                scores[i] = KILLER;
+            } else if (ply < MAX_PLY && packed == killers[ply][1]) {
+                scores[i] = KILLER - 1;
+            } else {
+                scores[i] = history[board.get_piece_at(move.current).side][square_index(move.current)][square_index(move.next)];
+            }
+        }
+    }
+
+    /*
+     * Swaps the highest scored move from index on into index, so moves are sorted only as far as the search gets.
+     */
+    static void pick(MoveList& moves, std::array<int, MoveList::capacity>& scores, size_t index) {
+        size_t best = index;
+        for (size_t i = index + 1; i < moves.size(); i++) {
+            if (scores[i] > scores[best])
+                best = i;
+        }
+        if (best != index) {
+            std::swap(moves[index], moves[best]);
+            std::swap(scores[index], scores[best]);
+        }
+    }
+
+    /*
+     * Called when a quiet move causes a beta cutoff, deeper searches count for more.
+     */
+    void cutoff(const Board& board, const Move& move, int depth, int ply) {
+        PackedMove packed(move);
+        if (ply < MAX_PLY && killers[ply][0] != packed) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = packed;
+        }
+        auto& value = history[board.get_piece_at(move.current).side][square_index(move.current)][square_index(move.next)];
+        value += depth * depth;
+        if (value >= HISTORY_LIMIT) {
+            for (auto& side: history)
+                for (auto& from: side)
+                    for (auto& to: from)
+                        to /= 2;
+        }
+    }
+
+private:
+    static const int BEST_MOVE = 1 << 30;
+    static const int CAPTURE = 1 << 29;
+    static const int KILLER = 1 << 28;
+    static const int HISTORY_LIMIT = 1 << 20;
+
+    std::array<std::array<PackedMove, 2>, MAX_PLY> killers;
+    std::array<std::array<std::array<int, 64>, 64>, 3> history;
+};
+
+#endif //CHESS_MOVE_ORDERING_H
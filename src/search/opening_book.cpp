@@ -0,0 +1,220 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "opening_book.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+OpeningBook::~OpeningBook() {
+    close();
+}
+
+bool OpeningBook::open(const std::string& path) {
+    close();
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+    struct stat info{};
+    if (fstat(file, &info) != 0 || info.st_size == 0 || info.st_size % ENTRY_SIZE != 0) {
+        ::close(file);
+        return false;
+    }
+    void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping holds its own reference to the file.
+    ::close(file);
+    if (mapped == MAP_FAILED)
+        return false;
+    data = static_cast<const unsigned char*>(mapped);
+    length = (size_t)info.st_size;
+    return true;
+}
+
+void OpeningBook::close() {
+    if (data)
+        munmap(const_cast<unsigned char*>(data), length);
+    data = nullptr;
+    length = 0;
+}
+
+static uint64_t read_big_endian(const unsigned char* bytes, int count) {
+    uint64_t value = 0;
+    for (int i = 0; i < count; i++)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+static void write_big_endian(std::ostream& out, uint64_t value, int count) {
+    for (int i = count - 1; i >= 0; i--)
+        out.put((char)((value >> (8 * i)) & 0xff));
+}
+
+BookEntry OpeningBook::entry(size_t index) const {
+    const unsigned char* bytes = data + index * ENTRY_SIZE;
+    return {read_big_endian(bytes, 8), (uint16_t)read_big_endian(bytes + 8, 2),
+            (uint16_t)read_big_endian(bytes + 10, 2), (uint32_t)read_big_endian(bytes + 12, 4)};
+}
+
+std::vector<BookMove> OpeningBook::moves(const Board& board) const {
+    std::vector<BookMove> found;
+    if (!is_open())
+        return found;
+    uint64_t position = key(board);
+    // The first entry with the key, the rest follow it.
+    size_t low = 0, high = size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (read_big_endian(data + middle * ENTRY_SIZE, 8) < position)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    for (size_t i = low; i < size(); i++) {
+        auto book_entry = entry(i);
+        if (book_entry.key != position)
+            break;
+        Move move = decode(board, book_entry.move);
+        if (move.type != Unclassified && book_entry.weight > 0)
+            found.push_back({move, book_entry.weight});
+    }
+    return found;
+}
+
+std::optional<Move> OpeningBook::pick(const Board& board, uint32_t random) const {
+    auto book_moves = moves(board);
+    uint32_t total = 0;
+    for (const auto& book_move: book_moves)
+        total += book_move.weight;
+    if (total == 0)
+        return std::nullopt;
+    uint32_t chosen = random % total;
+    for (const auto& book_move: book_moves) {
+        if (chosen < (uint32_t)book_move.weight)
+            return book_move.move;
+        chosen -= book_move.weight;
+    }
+    return std::nullopt;
+}
+
+/*
+ * Polyglot counts ranks from White's side and pieces in a different order to Pieces.
+ */
+static int book_square(BoardPosition position) {
+    return (7 - position.row) * 8 + position.column;
+}
+
+static BoardPosition board_square(int square) {
+    return {7 - square / 8, square % 8};
+}
+
+static int book_kind(Piece piece) {
+    int kind = 0;
+    switch (piece.type) {
+        case Pawn: kind = 0; break;
+        case Knight: kind = 1; break;
+        case Bishop: kind = 2; break;
+        case Rook: kind = 3; break;
+        case Queen: kind = 4; break;
+        case King: kind = 5; break;
+        case None: break;
+    }
+    return 2 * kind + (piece.side == White ? 1 : 0);
+}
+
+/*
+ * The en passant file only counts when a pawn of the side to move stands next to the pawn that moved two squares.
+ */
+uint64_t OpeningBook::key(const Board& board) {
+    uint64_t hash = 0;
+    for (int row = 0; row < 8; row++) {
+        for (int column = 0; column < 8; column++) {
+            auto piece = board.get_piece_at(row, column);
+            if (piece.type != None)
+                hash ^= polyglot::random64[64 * book_kind(piece) + book_square({row, column})];
+        }
+    }
+
+    int rights = board.castling_rights();
+    const int order[] = {WhiteKingSide, WhiteQueenSide, BlackKingSide, BlackQueenSide};
+    for (int i = 0; i < 4; i++)
+        if (rights & order[i])
+            hash ^= polyglot::random64[polyglot::CASTLING_OFFSET + i];
+
+    Side side = board.side_to_move();
+    int en_passant = board.en_passant_square();
+    if (en_passant >= 0) {
+        auto target = square_position(en_passant);
+        int pawn_row = side == White ? target.row + 1 : target.row - 1;
+        for (int column: {target.column - 1, target.column + 1}) {
+            auto piece = board.get_piece_at(pawn_row, column);
+            if (piece.type == Pawn && piece.side == side) {
+                hash ^= polyglot::random64[polyglot::EN_PASSANT_OFFSET + target.column];
+                break;
+            }
+        }
+    }
+
+    if (side == White)
+        hash ^= polyglot::random64[polyglot::TURN_OFFSET];
+    return hash;
+}
+
+uint16_t OpeningBook::encode(const Move& move) {
+    BoardPosition to = move.next;
+    if (move.type == King_KingSideCastle)
+        to.column = 7;
+    else if (move.type == King_QueenSideCastle)
+        to.column = 0;
+    int promotion = 0;
+    if (move.type == Pawn_Promotion) {
+        switch (move.promotion) {
+            case Knight: promotion = 1; break;
+            case Bishop: promotion = 2; break;
+            case Rook: promotion = 3; break;
+            default: promotion = 4; break;
+        }
+    }
+    return (uint16_t)(book_square(to) | (book_square(move.current) << 6) | (promotion << 12));
+}
+
+Move OpeningBook::decode(const Board& board, uint16_t book_move) {
+    BoardPosition to = board_square(book_move & 63);
+    BoardPosition from = board_square((book_move >> 6) & 63);
+    int promotion = (book_move >> 12) & 7;
+    // 5 to 7 aren't pieces, only a broken or made up book has them.
+    if (promotion > 4)
+        return {};
+
+    auto piece = board.get_piece_at(from);
+    auto target = board.get_piece_at(to);
+    if (piece.type == King && target.type == Rook && target.side == piece.side)
+        to.column = to.column > from.column ? 6 : 2;
+
+    Move move(from, to);
+    const Pieces promotions[] = {Queen, Knight, Bishop, Rook, Queen};
+    move.promotion = promotions[promotion];
+    if (!board.legal(move))
+        return {};
+    return move;
+}
+
+bool OpeningBook::write(const std::string& path, std::vector<BookEntry> entries) {
+    std::sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) {
+        return a.key != b.key ? a.key < b.key : a.weight > b.weight;
+    });
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+    for (const auto& book_entry: entries) {
+        write_big_endian(out, book_entry.key, 8);
+        write_big_endian(out, book_entry.move, 2);
+        write_big_endian(out, book_entry.weight, 2);
+        write_big_endian(out, book_entry.learn, 4);
+    }
+    return (bool)out;
+}
@@ -0,0 +1,424 @@
+//
+// Created by Chris Luttio on 1/16/22.
+//
+
+#include "search.h"
+
+#include <algorithm>
+
+#include "pure_states/see.h"
+
+SearchResult Search::run(const Board& position, const SearchLimits& search_limits, int first_depth) {
+    started = TimeManager::Clock::now();
+    // started moves on when pondering turns into searching, the result's time is from here.
+    auto begun = started;
+    limits = search_limits;
+    if (limits.time && !limits.deadline)
+        limits.deadline = started + limits.time->maximum;
+    aborted = false;
+    ponder_pending = limits.ponder && limits.ponder->load();
+
+    Board board = position;
+    Side side = board.side_to_move();
+    auto moves = board.legal_moves(side);
+
+    SearchResult result;
+    stats = {};
+    nodes_shared = 0;
+    ordering.clear();
+    if (moves.empty())
+        return result;
+
+    std::array<int, MoveList::capacity> scores;
+    TranspositionEntry entry;
+    ordering.score(board, moves, table->probe(board.key, entry) ? entry.move : PackedMove(), 0, scores);
+    for (size_t i = 0; i < moves.size(); i++)
+        MoveOrdering::pick(moves, scores, i);
+    result.move = moves[0];
+
+    int best_move_changes = 0;
+    int lines = std::clamp(options.multi_pv, 1, (int)moves.size());
+    for (int depth = std::max(1, first_depth); depth <= limits.depth; depth++) {
+        root_depth = depth;
+        auto iteration_started = TimeManager::Clock::now();
+        uint64_t iteration_nodes = stats.nodes;
+        int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+        int window = std::max(1, (int)(ASPIRATION_WINDOW * options.pawn_value));
+        // With more than one line the window would have to hold the worst of them, so there isn't one.
+        if (depth >= ASPIRATION_DEPTH && result.depth > 0 && lines == 1 && !is_mate_score(result.score)) {
+            alpha = result.score - window;
+            beta = result.score + window;
+        }
+        while (true) {
+            int score = search_root(board, moves, depth, alpha, beta);
+            if (stopped() || (score > alpha && score < beta))
+                break;
+            stats.aspiration_re_searches++;
+            window *= 4;
+            if (score <= alpha)
+                alpha = std::max(-INFINITE_SCORE, score - window);
+            else
+                beta = std::min(INFINITE_SCORE, score + window);
+            if (is_mate_score(score))
+                alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+        }
+        SearchIteration iteration{depth, 0, stats.nodes - iteration_nodes,
+                                  std::chrono::duration_cast<std::chrono::microseconds>(TimeManager::Clock::now() - iteration_started), !stopped()};
+        if (iteration.finished)
+            iteration.score = root_lines.front().score;
+        result.iterations.push_back(iteration);
+        if (stopped())
+            break;
+
+        Move best_move = board.unpack_move(root_lines.front().moves.front());
+        if (result.depth > 0 && PackedMove(best_move) != PackedMove(result.move))
+            best_move_changes++;
+        result.move = best_move;
+        result.score = root_lines.front().score;
+        result.depth = depth;
+        result.lines.clear();
+        for (const auto& line: root_lines)
+            result.lines.push_back({line.score, unpack_line(board, line.moves)});
+        result.pv = result.lines.front().moves;
+        table->store(board.key, depth, ExactBound, score_to_table(result.score, 0), PackedMove(best_move));
+
+        // The best moves go first next iteration, so the rest are searched against their scores.
+        for (auto line = root_lines.rbegin(); line != root_lines.rend(); line++) {
+            for (size_t i = 0; i < moves.size(); i++) {
+                if (PackedMove(moves[i]) == line->moves.front()) {
+                    std::rotate(moves.begin(), moves.begin() + i, moves.begin() + i + 1);
+                    break;
+                }
+            }
+        }
+
+        // With extensions a mate can turn up past the iteration's depth, there may be a shorter one within the next.
+        if (is_mate_score(result.score) && MATE_SCORE - abs(result.score) <= depth)
+            break;
+        if (pondering() || !limits.time)
+            continue;
+        auto elapsed = std::chrono::duration_cast<TimeManager::Duration>(TimeManager::Clock::now() - started);
+        if (!limits.time->keep_deepening(elapsed, best_move_changes, moves.size()))
+            break;
+    }
+    result.stats = stats;
+    result.time = std::chrono::duration_cast<std::chrono::microseconds>(TimeManager::Clock::now() - begun);
+    return result;
+}
+
+/*
+ * With more than one line, a move only needs to beat the worst of the lines kept so far to get its exact score,
+ * so that is what it is searched against instead of the best.
+ */
+int Search::search_root(Board& board, MoveList& moves, int depth, int alpha, int beta) {
+    size_t lines = std::clamp(options.multi_pv, 1, (int)moves.size());
+    root_lines.clear();
+    int best_score = -INFINITE_SCORE;
+    for (size_t i = 0; i < moves.size(); i++) {
+        const auto& move = moves[i];
+        int bound = root_lines.size() < lines ? alpha : std::max(alpha, root_lines.back().score);
+        auto undo = board.make_move(move);
+        int score;
+        if (i == 0) {
+            score = -negamax(board, depth - 1, 1, -beta, -bound);
+        } else {
+            score = -negamax(board, depth - 1, 1, -bound - 1, -bound);
+            if (score > bound && score < beta && !stopped()) {
+                stats.pvs_re_searches++;
+                score = -negamax(board, depth - 1, 1, -beta, -bound);
+            }
+        }
+        board.unmake_move(undo);
+        if (stopped())
+            return 0;
+        best_score = std::max(best_score, score);
+        if (score <= bound)
+            continue;
+
+        update_pv(0, move);
+        PackedLine line{score, {pv[0].begin(), pv[0].begin() + pv_length[0]}};
+        auto position = std::find_if(root_lines.begin(), root_lines.end(), [&](const PackedLine& other) { return other.score < score; });
+        root_lines.insert(position, std::move(line));
+        if (root_lines.size() > lines)
+            root_lines.pop_back();
+        if (score >= beta)
+            break;
+    }
+    return best_score;
+}
+
+int Search::negamax(Board& board, int depth, int ply, int alpha, int beta, bool allow_null) {
+    pv_length[ply] = ply;
+    Side side = board.side_to_move();
+    bool in_check = board.king_in_check(side);
+    // Limited to twice the iteration's depth, a long run of checks could otherwise go on to the last ply.
+    if (in_check && options.check_extensions && ply < 2 * root_depth) {
+        depth++;
+        stats.check_extensions++;
+    }
+    if (depth <= 0)
+        return quiescence(board, ply, alpha, beta);
+    if (stopped())
+        return 0;
+    stats.nodes++;
+
+    // The bitbases and the table are looked at before generating moves, which a cutoff doesn't need.
+    // A mated or stalemated side is never stored, its score is returned before reaching the table.
+    if (bitbases) {
+        auto result = bitbases->probe(board);
+        if (result)
+            stats.bitbase_hits++;
+        if (result == Draw)
+            return 0;
+    }
+
+    int original_alpha = alpha;
+    TranspositionEntry entry;
+    PackedMove table_move;
+    stats.table_probes++;
+    if (table->probe(board.key, entry)) {
+        stats.table_hits++;
+        table_move = entry.move;
+        if (entry.depth >= depth) {
+            int score = score_from_table(entry.score, ply);
+            if (entry.bound == ExactBound || (entry.bound == LowerBound && score >= beta) || (entry.bound == UpperBound && score <= alpha)) {
+                stats.table_cutoffs++;
+                return score;
+            }
+        }
+    }
+
+    ScopedFrame frame(*this);
+    auto& moves = frame->moves;
+    board.legal_moves(side, moves);
+    if (moves.empty())
+        return in_check ? -MATE_SCORE + ply : 0;
+    if (ply >= MAX_PLY)
+        return evaluate(board);
+
+    // Pruning is only safe out of check, and only against a bound that isn't a mate (or infinite).
+    bool prunable = !in_check;
+    bool prune_below_alpha = prunable && !is_mate_score(alpha);
+    bool prune_above_beta = prunable && !is_mate_score(beta);
+    int static_score = prune_below_alpha || prune_above_beta ? evaluate(board) : 0;
+
+    if (prune_below_alpha && options.razoring && depth <= 2 && static_score + RAZOR_MARGINS[depth] * options.pawn_value <= alpha) {
+        int score = quiescence(board, ply, alpha, alpha + 1);
+        if (stopped())
+            return 0;
+        if (score <= alpha) {
+            stats.razor_prunes++;
+            return score;
+        }
+    }
+
+    Bitboard pieces = board.get_piece_board(Knight, side) | board.get_piece_board(Bishop, side)
+                      | board.get_piece_board(Rook, side) | board.get_piece_board(Queen, side);
+    if (prune_above_beta && options.null_move && allow_null && depth >= 3 && pieces && static_score >= beta) {
+        int reduction = depth >= 7 ? 3 : 2;
+        stats.null_move_tries++;
+        auto undo = board.make_null_move();
+        int score = -negamax(board, depth - 1 - reduction, ply + 1, -beta, -beta + 1, false);
+        board.unmake_null_move(undo);
+        if (stopped())
+            return 0;
+        if (score >= beta) {
+            // A mate found after passing isn't a real one.
+            if (is_mate_score(score))
+                score = beta;
+            if (!options.null_move_verification || depth < NULL_MOVE_VERIFICATION_DEPTH) {
+                stats.null_move_cutoffs++;
+                return score;
+            }
+            int verified = negamax(board, depth - 1 - reduction, ply, beta - 1, beta, false);
+            if (stopped())
+                return 0;
+            if (verified >= beta) {
+                stats.null_move_cutoffs++;
+                return score;
+            }
+            stats.null_move_verification_failures++;
+        }
+    }
+
+    bool futile = prune_below_alpha && options.futility_pruning && depth <= 2
+                  && static_score + FUTILITY_MARGINS[depth] * options.pawn_value <= alpha;
+
+    auto& scores = frame->scores;
+    ordering.score(board, moves, table_move, ply, scores);
+
+    // The null move's verification search may have left a line here.
+    pv_length[ply] = ply;
+    int best_score = -INFINITE_SCORE;
+    Move best_move;
+    for (size_t i = 0; i < moves.size(); i++) {
+        MoveOrdering::pick(moves, scores, i);
+        const auto& move = moves[i];
+        // Castling changes the scorers' idea of the position too much to count as quiet here.
+        bool quiet = MoveOrdering::is_quiet(board, move) && move.type != King_KingSideCastle && move.type != King_QueenSideCastle;
+        auto undo = board.make_move(move);
+        bool gives_check = board.king_in_check(board.side_to_move());
+
+        if (futile && quiet && !gives_check && i > 0) {
+            board.unmake_move(undo);
+            stats.futility_prunes++;
+            best_score = std::max(best_score, static_score + FUTILITY_MARGINS[depth] * options.pawn_value);
+            continue;
+        }
+
+        int score;
+        if (i == 0) {
+            score = -negamax(board, depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            int reduction = 0;
+            if (options.late_move_reductions && prunable && quiet && !gives_check && depth >= 3 && i >= LATE_MOVE_INDEX) {
+                reduction = i >= 2 * LATE_MOVE_INDEX ? 2 : 1;
+                stats.reductions++;
+            }
+            score = -negamax(board, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+            if (reduction > 0 && score > alpha && !stopped()) {
+                stats.reduction_re_searches++;
+                score = -negamax(board, depth - 1, ply + 1, -alpha - 1, -alpha);
+            }
+            if (score > alpha && score < beta && !stopped()) {
+                stats.pvs_re_searches++;
+                score = -negamax(board, depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        board.unmake_move(undo);
+        if (stopped())
+            return 0;
+        if (score > best_score) {
+            best_score = score;
+            best_move = move;
+        }
+        if (score > alpha) {
+            alpha = score;
+            update_pv(ply, move);
+        }
+        if (alpha >= beta) {
+            stats.beta_cutoffs++;
+            if (i == 0)
+                stats.first_move_cutoffs++;
+            stats.cutoff_moves[std::min(i, stats.cutoff_moves.size() - 1)]++;
+            if (MoveOrdering::is_quiet(board, move))
+                ordering.cutoff(board, move, depth, ply);
+            break;
+        }
+    }
+
+    Bound bound = best_score >= beta ? LowerBound : best_score > original_alpha ? ExactBound : UpperBound;
+    table->store(board.key, depth, bound, score_to_table(best_score, ply), bound == UpperBound ? PackedMove() : PackedMove(best_move));
+    return best_score;
+}
+
+/*
+ * Below the main search only captures and promotions to a queen are played, until the position is quiet enough to score.
+ * The side to move can stand pat, taking the static score instead of capturing, since it doesn't have to capture.
+ * In check it can't, so every evasion is searched.
+ */
+int Search::quiescence(Board& board, int ply, int alpha, int beta) {
+    pv_length[ply] = ply;
+    if (stopped())
+        return 0;
+    stats.nodes++;
+    stats.qnodes++;
+
+    Side side = board.side_to_move();
+    ScopedFrame frame(*this);
+    auto& moves = frame->moves;
+    board.legal_moves(side, moves);
+    bool in_check = board.king_in_check(side);
+    if (moves.empty())
+        return in_check ? -MATE_SCORE + ply : 0;
+    if (ply >= MAX_PLY)
+        return evaluate(board);
+
+    int best_score = -INFINITE_SCORE;
+    if (!in_check) {
+        best_score = evaluate(board);
+        if (best_score >= beta)
+            return best_score;
+        if (best_score > alpha)
+            alpha = best_score;
+    }
+
+    auto& scores = frame->scores;
+    ordering.score(board, moves, {}, ply, scores);
+    for (size_t i = 0; i < moves.size(); i++) {
+        MoveOrdering::pick(moves, scores, i);
+        const auto& move = moves[i];
+        if (!in_check) {
+            // Captures are ordered first, so the rest are quiet.
+            if (MoveOrdering::is_quiet(board, move))
+                break;
+            if (move.type == Pawn_Promotion && move.promotion != Queen)
+                continue;
+            // Captures that lose material once the exchange plays out can't raise the score above standing pat.
+            if (static_exchange(board, move) < 0)
+                continue;
+        }
+        auto undo = board.make_move(move);
+        int score = -quiescence(board, ply + 1, -beta, -alpha);
+        board.unmake_move(undo);
+        if (score > best_score)
+            best_score = score;
+        if (score > alpha)
+            alpha = score;
+        if (alpha >= beta)
+            break;
+    }
+    return best_score;
+}
+
+void Search::update_pv(int ply, const Move& move) {
+    pv[ply][ply] = PackedMove(move);
+    int length = std::max(pv_length[ply + 1], ply + 1);
+    for (int i = ply + 1; i < length; i++)
+        pv[ply][i] = pv[ply + 1][i];
+    pv_length[ply] = length;
+}
+
+std::vector<Move> Search::unpack_line(Board board, const std::vector<PackedMove>& line) {
+    std::vector<Move> moves;
+    for (auto packed: line) {
+        Move move = board.unpack_move(packed);
+        if (!board.legal(move))
+            break;
+        moves.push_back(move);
+        board.make_move(move);
+    }
+    return moves;
+}
+
+int Search::evaluate(const Board& board) const {
+    Side side = board.side_to_move();
+    Side enemy = side == White ? Black : White;
+    int score = scorer->score(board, side) - scorer->score(board, enemy);
+    if (bitbases) {
+        auto result = bitbases->probe(board);
+        if (result == Draw)
+            return 0;
+        if (result == Win)
+            return score + KNOWN_WIN_SCORE + Bitbases::progress(board);
+        if (result == Loss)
+            return score - KNOWN_WIN_SCORE - Bitbases::progress(board);
+    }
+    return score;
+}
+
+int Search::score_to_table(int score, int ply) {
+    if (score >= MATE_SCORE - MAX_PLY)
+        return score + ply;
+    if (score <= -MATE_SCORE + MAX_PLY)
+        return score - ply;
+    return score;
+}
+
+int Search::score_from_table(int score, int ply) {
+    if (score >= MATE_SCORE - MAX_PLY)
+        return score - ply;
+    if (score <= -MATE_SCORE + MAX_PLY)
+        return score + ply;
+    return score;
+}
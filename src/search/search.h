@@ -0,0 +1,433 @@
+//
+// Created by Chris Luttio on 1/16/22.
+//
+
+#ifndef CHESS_SEARCH_H
+#define CHESS_SEARCH_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "data_types.h"
+#include "pure_states/bitbases.h"
+#include "pure_states/board.h"
+#include "scorers/scorer.h"
+#include "move_ordering.h"
+#include "transposition_table.h"
+#include "time_manager.h"
+
+struct SearchStats {
+    /*
+     * Every position visited, and how many of those were in the quiescence search.
+     */
+    uint64_t nodes{0};
+    uint64_t qnodes{0};
+
+    /*
+     * Nodes where a move failed high, and how many of those it did on the first move tried.
+     * With good move ordering nearly all of them are on the first move.
+     */
+    uint64_t beta_cutoffs{0};
+    uint64_t first_move_cutoffs{0};
+
+    /*
+     * Beta cutoffs by the index of the move that caused them in the order tried, the last for every move from there on.
+     */
+    std::array<uint64_t, 8> cutoff_moves{};
+
+    /*
+     * Transposition table lookups in the main search, how many found the position, and how many of those ended the search of it.
+     */
+    uint64_t table_probes{0};
+    uint64_t table_hits{0};
+    uint64_t table_cutoffs{0};
+
+    /*
+     * How often each of the selective techniques in SearchOptions fired.
+     */
+    uint64_t null_move_tries{0};
+    uint64_t null_move_cutoffs{0};
+    uint64_t null_move_verification_failures{0};
+    uint64_t reductions{0};
+    uint64_t reduction_re_searches{0};
+    uint64_t futility_prunes{0};
+    uint64_t razor_prunes{0};
+    uint64_t check_extensions{0};
+
+    /*
+     * Moves searched again with the full window after beating alpha in a zero window search,
+     * and iterations searched again after their score fell outside the aspiration window.
+     */
+    uint64_t pvs_re_searches{0};
+    uint64_t aspiration_re_searches{0};
+
+    /*
+     * Positions found in the endgame bitbases.
+     */
+    uint64_t bitbase_hits{0};
+
+    [[nodiscard]] double first_move_cutoff_rate() const {
+        return beta_cutoffs == 0 ? 0 : (double)first_move_cutoffs / (double)beta_cutoffs;
+    }
+
+    [[nodiscard]] double table_hit_rate() const {
+        return table_probes == 0 ? 0 : (double)table_hits / (double)table_probes;
+    }
+};
+
+/*
+ * One iteration of iterative deepening, finished or not.
+ */
+struct SearchIteration {
+    int depth{0};
+    int score{0};
+    uint64_t nodes{0};
+    std::chrono::microseconds time{0};
+    bool finished{false};
+};
+
+/*
+ * How long a scorer took over a search, across all the threads that used it.
+ */
+struct ScorerTime {
+    std::string name;
+    uint64_t calls{0};
+    std::chrono::nanoseconds time{0};
+};
+
+/*
+ * Which moves the search may skip or search less deeply, and which it searches deeper.
+ *
+ * Null move: if passing the turn still fails high at a reduced depth, so will any real move. In zugzwang that's wrong,
+ *  so it isn't tried without pieces other than pawns, and deep enough the cutoff is verified by a reduced search without the pass.
+ * Late move reductions: quiet moves ordered late rarely turn out best, so they are searched shallower, and again at full depth if they beat alpha.
+ * Futility pruning: a ply or two from the leaves, quiet moves are skipped when the position is so far below alpha that they can't catch up.
+ * Razoring: near the leaves, a position far enough below alpha goes straight to the quiescence search, and is given up on if that agrees.
+ * Check extensions: a side in check is searched a ply deeper, so forcing lines aren't cut off halfway.
+ *
+ * The margins are in pawns, scaled by what a pawn is worth to the scorer.
+ */
+struct SearchOptions {
+    bool null_move{true};
+    bool null_move_verification{true};
+    bool late_move_reductions{true};
+    bool futility_pruning{true};
+    bool razoring{true};
+    bool check_extensions{true};
+
+    int pawn_value{10};
+
+    /*
+     * How many of the best root moves get an exact score and a line in the result, instead of only the best.
+     */
+    int multi_pv{1};
+
+    /*
+     * Every move to its full depth, for comparing against.
+     */
+    [[nodiscard]] static SearchOptions full_width() {
+        return {false, false, false, false, false, false};
+    }
+};
+
+/*
+ * A line of play the search expects, starting with a root move, and what it scores for the side to move at the root.
+ */
+struct SearchLine {
+    int score{0};
+    std::vector<Move> moves;
+};
+
+struct SearchResult {
+    Move move;
+    int score{0};
+    int depth{0};
+    SearchStats stats;
+
+    /*
+     * The principal variation, the line starting with the move that both sides are expected to play.
+     * It can stop short of the depth where the transposition table cut the search off.
+     */
+    std::vector<Move> pv;
+
+    /*
+     * The best SearchOptions::multi_pv lines, each starting with a different move, best first. The first is the principal variation.
+     */
+    std::vector<SearchLine> lines;
+
+    /*
+     * Wall time from the start of the search to its end, and each iteration's share of it.
+     */
+    std::chrono::microseconds time{0};
+    std::vector<SearchIteration> iterations;
+
+    /*
+     * Filled in by players that time their scorers, see TimedScorer.
+     */
+    std::vector<ScorerTime> scorer_times;
+
+    [[nodiscard]] double nodes_per_second() const {
+        return time.count() == 0 ? 0 : (double)stats.nodes * 1e6 / (double)time.count();
+    }
+
+    /*
+     * How many times more nodes the last finished iteration took than the one before it.
+     */
+    [[nodiscard]] double branching_factor() const {
+        const SearchIteration* last = nullptr;
+        const SearchIteration* previous = nullptr;
+        for (const auto& iteration: iterations) {
+            if (!iteration.finished)
+                continue;
+            previous = last;
+            last = &iteration;
+        }
+        if (!last || !previous || previous->nodes == 0)
+            return 0;
+        return (double)last->nodes / (double)previous->nodes;
+    }
+};
+
+/*
+ * When to give up on searching deeper. The search stops at whichever comes first, and is otherwise only limited by the depth.
+ */
+struct SearchLimits {
+    int depth{MoveOrdering::MAX_PLY};
+
+    /*
+     * How many nodes to search, 0 for no limit.
+     */
+    uint64_t nodes{0};
+
+    /*
+     * Searches running together (Lazy SMP) all add their nodes here, so nodes limits them together rather than each of them.
+     */
+    std::atomic<uint64_t>* shared_nodes{nullptr};
+
+    std::optional<TimeManager::Clock::time_point> deadline;
+
+    /*
+     * Set from another thread to stop the search, e.g. when the game is closed.
+     */
+    const std::atomic<bool>* stop{nullptr};
+
+    /*
+     * Decides between iterations whether another is worth starting, and sets the deadline if there isn't one.
+     */
+    const TimeManager* time{nullptr};
+
+    /*
+     * While this is set the search is pondering, searching the position it expects on the opponent's time,
+     * so the deadline and the time manager are ignored. Once it is cleared the clock starts.
+     */
+    const std::atomic<bool>* ponder{nullptr};
+};
+
+/*
+ * Alpha-beta negamax with iterative deepening.
+ *
+ * Every score is from the point of view of the side to move, so a position's score is minus the best score of the positions after it.
+ * A position is scored with the scorer for the side to move minus the scorer for the other side, since the scorers only look at one side.
+ * Checkmate and stalemate are found by the search itself, a mate found n plies from the root scores MATE_SCORE - n.
+ * Past the last ply captures are searched until the position is quiet, so a leaf isn't scored in the middle of an exchange.
+ *
+ * The depth is searched one ply at a time, trying the best move of the last iteration first at the root.
+ * Each iteration starts with a narrow aspiration window around the last one's score, widened if the score falls outside it.
+ * Principal variation search: only the first move at a node gets the full window. The rest are searched with a zero window
+ * that can only tell whether they beat it, and again with the full window if one does.
+ * Moves are tried in the order MoveOrdering gives them, which learns from cutoffs as the search goes.
+ * The options decide which moves are pruned, reduced or extended on the way.
+ * Results are kept in the transposition table, which can be shared with other searches.
+ *
+ * With bitbases, a drawn ending is scored 0 without searching it, and a won one is scored KNOWN_WIN_SCORE more than the scorer gives it
+ * plus Bitbases::progress, so a mate the search can't see yet is still worked towards. A mate it can see scores higher still.
+ */
+struct Search {
+    static constexpr int MATE_SCORE = 1000000;
+    static constexpr int INFINITE_SCORE = MATE_SCORE + 1;
+    static constexpr int MAX_PLY = MoveOrdering::MAX_PLY;
+    static constexpr int KNOWN_WIN_SCORE = MATE_SCORE / 10;
+
+    Search(std::shared_ptr<Scorer> scorer, std::shared_ptr<TranspositionTable> table):
+        scorer(std::move(scorer)), table(std::move(table)) {}
+
+    /*
+     * Searches the side to move's moves from first_depth plies deeper until a limit is reached. The move is left unclassified if there are none.
+     * Once a limit is reached the search unwinds as quickly as it can, without storing anything it was in the middle of,
+     * and the result is from the last iteration that finished. If not even the first one did, it is the move ordered first.
+     */
+    SearchResult run(const Board& board, const SearchLimits& limits, int first_depth = 1);
+
+    SearchResult run(const Board& board, int max_depth, int first_depth = 1) {
+        SearchLimits depth_limit;
+        depth_limit.depth = max_depth;
+        return run(board, depth_limit, first_depth);
+    }
+
+    [[nodiscard]] static bool is_mate_score(int score) {
+        return abs(score) >= MATE_SCORE - MAX_PLY;
+    }
+
+    SearchOptions options;
+    std::shared_ptr<const Bitbases> bitbases;
+
+private:
+    /*
+     * Margins in pawns by depth.
+     */
+    static constexpr std::array<int, 3> RAZOR_MARGINS{0, 3, 5};
+    static constexpr std::array<int, 3> FUTILITY_MARGINS{0, 2, 5};
+
+    /*
+     * Null move cutoffs are only verified from this depth, below it the verification costs about as much as the search it saves.
+     */
+    static const int NULL_MOVE_VERIFICATION_DEPTH = 5;
+
+    /*
+     * Quiet moves from this one on are reduced by a ply, and from twice this by two.
+     */
+    static const int LATE_MOVE_INDEX = 3;
+
+    /*
+     * Iterations from this depth start with an aspiration window this many pawns either side of the last score.
+     * The scores of the first few iterations swing too much for a window to help.
+     */
+    static const int ASPIRATION_DEPTH = 4;
+    static constexpr double ASPIRATION_WINDOW = 0.5;
+
+    struct PackedLine {
+        int score;
+        std::vector<PackedMove> moves;
+    };
+
+    /*
+     * The clock is only read every 1024 nodes, reading it is slower than searching a node.
+     */
+    [[nodiscard]] bool stopped() {
+        if (aborted)
+            return true;
+        if (limits.stop && limits.stop->load(std::memory_order_relaxed))
+            aborted = true;
+        else if (limits.nodes != 0 && counted_nodes() >= limits.nodes)
+            aborted = true;
+        else if ((stats.nodes & 1023) == 0 && !pondering() && limits.deadline && TimeManager::Clock::now() >= *limits.deadline)
+            aborted = true;
+        return aborted;
+    }
+
+    /*
+     * The nodes counted against the limit, every sharing search's when they are shared.
+     * This search's are added to the shared count 64 at a time, so the threads aren't all writing to it on every node.
+     */
+    [[nodiscard]] uint64_t counted_nodes() {
+        if (!limits.shared_nodes)
+            return stats.nodes;
+        uint64_t unshared = stats.nodes - nodes_shared;
+        if (unshared >= 64) {
+            limits.shared_nodes->fetch_add(unshared, std::memory_order_relaxed);
+            nodes_shared = stats.nodes;
+            unshared = 0;
+        }
+        return limits.shared_nodes->load(std::memory_order_relaxed) + unshared;
+    }
+
+    /*
+     * When the ponder flag is cleared the expected move was played, so the search goes on from here on the clock.
+     */
+    [[nodiscard]] bool pondering() {
+        if (ponder_pending && !limits.ponder->load(std::memory_order_relaxed)) {
+            ponder_pending = false;
+            started = TimeManager::Clock::now();
+            if (limits.time)
+                limits.deadline = started + limits.time->maximum;
+        }
+        return ponder_pending;
+    }
+
+    /*
+     * A negamax or quiescence call's moves and their ordering scores, about 9 KB.
+     * A line MAX_PLY long of those would overflow a thread's stack, so they are kept in frames instead.
+     */
+    struct MoveFrame {
+        MoveList moves;
+        std::array<int, MoveList::capacity> scores;
+    };
+
+    /*
+     * Holds the next of the search's frames until it goes out of scope, adding one the first time the search gets this deep.
+     * A deque doesn't move its elements as it grows, so the frames held further up stay put.
+     */
+    class ScopedFrame {
+    public:
+        explicit ScopedFrame(Search& search): search(search) {
+            if (search.frames_used == search.frames.size())
+                search.frames.emplace_back();
+            frame = &search.frames[search.frames_used++];
+        }
+
+        ~ScopedFrame() {
+            search.frames_used--;
+        }
+
+        ScopedFrame(const ScopedFrame&) = delete;
+        ScopedFrame& operator=(const ScopedFrame&) = delete;
+
+        MoveFrame* operator->() const {
+            return frame;
+        }
+
+    private:
+        Search& search;
+        MoveFrame* frame;
+    };
+
+    /*
+     * Searches the root moves with the window, keeping the best multi_pv lines that beat alpha in root_lines. Returns the best score.
+     */
+    int search_root(Board& board, MoveList& moves, int depth, int alpha, int beta);
+    int negamax(Board& board, int depth, int ply, int alpha, int beta, bool allow_null = true);
+    int quiescence(Board& board, int ply, int alpha, int beta);
+
+    [[nodiscard]] int evaluate(const Board& board) const;
+
+    /*
+     * The line from ply on is the move followed by the line the search below it found.
+     */
+    void update_pv(int ply, const Move& move);
+    [[nodiscard]] static std::vector<Move> unpack_line(Board board, const std::vector<PackedMove>& line);
+
+    /*
+     * Mate scores are stored relative to the position they're stored for, not the root, so they stay right when reached at another ply.
+     */
+    [[nodiscard]] static int score_to_table(int score, int ply);
+    [[nodiscard]] static int score_from_table(int score, int ply);
+
+    std::shared_ptr<Scorer> scorer;
+    std::shared_ptr<TranspositionTable> table;
+    MoveOrdering ordering;
+    SearchStats stats;
+    SearchLimits limits;
+    bool aborted{false};
+    bool ponder_pending{false};
+    uint64_t nodes_shared{0};
+    std::deque<MoveFrame> frames;
+    size_t frames_used{0};
+    int root_depth{0};
+
+    /*
+     * pv[ply] holds the best line found from ply, in pv[ply][ply] to pv[ply][pv_length[ply] - 1].
+     */
+    std::array<std::array<PackedMove, MAX_PLY + 1>, MAX_PLY + 1> pv;
+    std::array<int, MAX_PLY + 1> pv_length{};
+    std::vector<PackedLine> root_lines;
+    TimeManager::Clock::time_point started;
+};
+
+#endif //CHESS_SEARCH_H
@@ -0,0 +1,98 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "telemetry.h"
+
+#include <sstream>
+
+/*
+ * e2e4, with the promotion piece after it (e7e8q).
+ */
+static std::string coordinates(const Move& move) {
+    if (move.type == Unclassified)
+        return "";
+    std::string text{(char)('a' + move.current.column), (char)('8' - move.current.row),
+                     (char)('a' + move.next.column), (char)('8' - move.next.row)};
+    if (move.type == Pawn_Promotion) {
+        switch (move.promotion) {
+            case Knight: text += 'n'; break;
+            case Bishop: text += 'b'; break;
+            case Rook: text += 'r'; break;
+            default: text += 'q'; break;
+        }
+    }
+    return text;
+}
+
+/*
+ * Scorer names are the only strings that aren't ours, so they are the only ones that need escaping.
+ */
+static std::string quoted(const std::string& text) {
+    std::string escaped = "\"";
+    for (char c: text) {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if ((unsigned char)c >= 0x20)
+            escaped += c;
+    }
+    return escaped + "\"";
+}
+
+std::string telemetry_json(const SearchResult& result) {
+    const auto& stats = result.stats;
+    std::ostringstream json;
+    json << "{\"move\":" << quoted(coordinates(result.move))
+         << ",\"score\":" << result.score
+         << ",\"depth\":" << result.depth
+         << ",\"time_us\":" << result.time.count()
+         << ",\"nodes\":" << stats.nodes
+         << ",\"qnodes\":" << stats.qnodes
+         << ",\"nps\":" << (uint64_t)result.nodes_per_second()
+         << ",\"branching_factor\":" << result.branching_factor()
+         << ",\"table\":{\"probes\":" << stats.table_probes << ",\"hits\":" << stats.table_hits << ",\"cutoffs\":" << stats.table_cutoffs << "}"
+         << ",\"beta_cutoffs\":" << stats.beta_cutoffs
+         << ",\"cutoff_moves\":[";
+    for (size_t i = 0; i < stats.cutoff_moves.size(); i++)
+        json << (i > 0 ? "," : "") << stats.cutoff_moves[i];
+    json << "]"
+         << ",\"null_move_cutoffs\":" << stats.null_move_cutoffs
+         << ",\"reductions\":" << stats.reductions
+         << ",\"futility_prunes\":" << stats.futility_prunes
+         << ",\"razor_prunes\":" << stats.razor_prunes
+         << ",\"check_extensions\":" << stats.check_extensions
+         << ",\"pvs_re_searches\":" << stats.pvs_re_searches
+         << ",\"aspiration_re_searches\":" << stats.aspiration_re_searches
+         << ",\"bitbase_hits\":" << stats.bitbase_hits
+         << ",\"iterations\":[";
+    for (size_t i = 0; i < result.iterations.size(); i++) {
+        const auto& iteration = result.iterations[i];
+        json << (i > 0 ? "," : "") << "{\"depth\":" << iteration.depth << ",\"score\":" << iteration.score
+             << ",\"nodes\":" << iteration.nodes << ",\"time_us\":" << iteration.time.count()
+             << ",\"finished\":" << (iteration.finished ? "true" : "false") << "}";
+    }
+    json << "],\"scorers\":[";
+    for (size_t i = 0; i < result.scorer_times.size(); i++) {
+        const auto& scorer = result.scorer_times[i];
+        json << (i > 0 ? "," : "") << "{\"name\":" << quoted(scorer.name) << ",\"calls\":" << scorer.calls
+             << ",\"time_us\":" << std::chrono::duration_cast<std::chrono::microseconds>(scorer.time).count() << "}";
+    }
+    json << "]}";
+    return json.str();
+}
+
+bool TelemetryLog::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    out.close();
+    out.open(path, std::ios::app);
+    return out.is_open();
+}
+
+void TelemetryLog::write(const SearchResult& result) {
+    auto line = telemetry_json(result);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!out.is_open())
+        return;
+    out << line << '\n';
+    out.flush();
+}
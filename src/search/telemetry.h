@@ -0,0 +1,41 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#ifndef CHESS_TELEMETRY_H
+#define CHESS_TELEMETRY_H
+
+#include <fstream>
+#include <mutex>
+#include <string>
+
+#include "search.h"
+
+/*
+ * A search result as one line of JSON: the move in coordinate notation, its score and depth, the counters,
+ * the rates worked out from them, and each iteration and scorer.
+ */
+[[nodiscard]] std::string telemetry_json(const SearchResult& result);
+
+/*
+ * Appends a line of JSON for each search it is given to a file, so runs can be compared and graphed afterwards.
+ * Lines are written whole even when more than one player shares the log.
+ */
+struct TelemetryLog {
+    /*
+     * Returns false if the file can't be opened for appending.
+     */
+    bool open(const std::string& path);
+
+    [[nodiscard]] bool is_open() const {
+        return out.is_open();
+    }
+
+    void write(const SearchResult& result);
+
+private:
+    std::ofstream out;
+    std::mutex mutex;
+};
+
+#endif //CHESS_TELEMETRY_H
@@ -0,0 +1,51 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#ifndef CHESS_TIME_MANAGER_H
+#define CHESS_TIME_MANAGER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+/*
+ * Decides how long to think about a move given what is left on the clock.
+ *
+ * The optimum is an even share of the remaining time plus most of the increment, the maximum a few times that,
+ * never more than a fraction of what is left. The search never runs past the maximum, and after each iteration it asks whether to go deeper.
+ * It goes deeper for longer when the best move keeps changing between iterations, or when there are many moves to choose from,
+ * and stops at once when there is only one.
+ */
+struct TimeManager {
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::milliseconds;
+
+    /*
+     * With no moves to go, the rest of the game is assumed to take another 30 moves.
+     */
+    explicit TimeManager(Duration remaining, Duration increment = Duration(0), int moves_to_go = 0) {
+        int moves = moves_to_go > 0 ? std::min(moves_to_go, 30) : 30;
+        optimum = remaining / moves + increment * 3 / 4;
+        maximum = std::min(optimum * 4, remaining / 3 + increment * 3 / 4);
+        optimum = std::min(optimum, maximum);
+    }
+
+    /*
+     * The next iteration usually takes longer than all of the ones before it together,
+     * so one is only started while less than half of the time to spend is gone.
+     */
+    [[nodiscard]] bool keep_deepening(Duration elapsed, int best_move_changes, size_t legal_moves) const {
+        if (legal_moves <= 1)
+            return false;
+        double stability = 1.0 + 0.5 * std::min(best_move_changes, 4);
+        double complexity = std::clamp((double)legal_moves / 30.0, 0.75, 1.5);
+        double budget = std::min((double)optimum.count() * stability * complexity, (double)maximum.count());
+        return (double)elapsed.count() * 2 < budget;
+    }
+
+    Duration optimum;
+    Duration maximum;
+};
+
+#endif //CHESS_TIME_MANAGER_H
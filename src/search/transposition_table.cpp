@@ -0,0 +1,83 @@
+//
+// Created by Chris Luttio on 1/15/22.
+//
+
+#include "transposition_table.h"
+
+#include <algorithm>
+
+/*
+ * The number of clusters is rounded down to a power of two so a key's cluster is a mask of its low bits.
+ */
+TranspositionTable::TranspositionTable(size_t megabytes): generation(0) {
+    size_t count = 1;
+    while (count * 2 * sizeof(Cluster) <= megabytes * 1024 * 1024)
+        count *= 2;
+    cluster_count = count;
+    clusters = std::make_unique<Cluster[]>(count);
+}
+
+bool TranspositionTable::probe(uint64_t key, TranspositionEntry& entry) const {
+    for (auto& slot: cluster_for(key).slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && data != 0) {
+            entry = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, Bound bound, int score, PackedMove move) {
+    auto& cluster = cluster_for(key);
+    int current = generation.load(std::memory_order_relaxed);
+    Slot* replace = nullptr;
+    int replace_worth = 0;
+    for (auto& slot: cluster.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && data != 0) {
+            if (depth < depth_of(data) && bound != ExactBound)
+                return;
+            // Keep the best move from the earlier search if this one didn't find one.
+            if (move.empty())
+                move.data = (uint16_t)data;
+            replace = &slot;
+            break;
+        }
+        int age = (current - generation_of(data)) & 63;
+        int worth = data == 0 ? -1000 : depth_of(data) - 8 * age;
+        if (!replace || worth < replace_worth) {
+            replace = &slot;
+            replace_worth = worth;
+        }
+    }
+    uint64_t data = pack(depth, bound, score, move, current);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < cluster_count; i++) {
+        for (auto& slot: clusters[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation.store(0, std::memory_order_relaxed);
+}
+
+int TranspositionTable::permille_full() const {
+    int current = generation.load(std::memory_order_relaxed);
+    int used = 0;
+    size_t clusters_sampled = std::min<size_t>(cluster_count, 1000 / cluster_size);
+    for (size_t i = 0; i < clusters_sampled; i++) {
+        for (const auto& slot: clusters[i].slots) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (data != 0 && generation_of(data) == current)
+                used++;
+        }
+    }
+    return (int)(used * 1000 / (clusters_sampled * cluster_size));
+}
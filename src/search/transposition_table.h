@@ -0,0 +1,118 @@
+//
+// Created by Chris Luttio on 1/15/22.
+//
+
+#ifndef CHESS_TRANSPOSITION_TABLE_H
+#define CHESS_TRANSPOSITION_TABLE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "data_types.h"
+
+/*
+ * How a stored score relates to the position's real score.
+ * A search that fails low only shows the score is at most the stored one, a search that fails high that it is at least the stored one.
+ */
+enum Bound {
+    NoBound,
+    UpperBound,
+    LowerBound,
+    ExactBound,
+};
+
+struct TranspositionEntry {
+    PackedMove move;
+    int score{0};
+    int depth{0};
+    Bound bound{NoBound};
+};
+
+/*
+ * A fixed-size table of search results by Zobrist key, which any number of search threads can share without locks.
+ *
+ * Entries are grouped in clusters of four that fill a cache line, a key can only be stored in the cluster its low bits pick.
+ * Each entry is two words, the packed result and the result XORed with the key.
+ * Two threads writing the same entry at once can leave the words from different results,
+ * the XOR then no longer gives back the key and the entry reads as a miss.
+ *
+ * A key already in its cluster is overwritten unless the new result is from a shallower search and isn't exact.
+ * Otherwise the entry replaced is the one searched least deeply, with entries from earlier searches counted as shallower.
+ */
+struct TranspositionTable {
+    static const int cluster_size = 4;
+
+    explicit TranspositionTable(size_t megabytes);
+
+    [[nodiscard]] bool probe(uint64_t key, TranspositionEntry& entry) const;
+    void store(uint64_t key, int depth, Bound bound, int score, PackedMove move);
+
+    /*
+     * Marks everything already in the table as coming from an earlier search, so it is replaced first.
+     */
+    void new_search() {
+        generation.store((generation.load(std::memory_order_relaxed) + 1) & 63, std::memory_order_relaxed);
+    }
+
+    void clear();
+
+    [[nodiscard]] size_t size() const {
+        return cluster_count * cluster_size;
+    }
+
+    /*
+     * How many of the first thousand entries hold results from the current search.
+     */
+    [[nodiscard]] int permille_full() const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    struct alignas(64) Cluster {
+        std::array<Slot, cluster_size> slots;
+    };
+
+    /*
+     * The 64 bits of data are, from the lowest: 16 for the move, 32 for the score, 8 for the depth, 2 for the bound and 6 for the generation.
+     */
+    [[nodiscard]] static uint64_t pack(int depth, Bound bound, int score, PackedMove move, int generation) {
+        return (uint64_t)move.data
+            | ((uint64_t)(uint32_t)score << 16)
+            | ((uint64_t)(uint8_t)depth << 48)
+            | ((uint64_t)bound << 56)
+            | ((uint64_t)generation << 58);
+    }
+
+    [[nodiscard]] static TranspositionEntry unpack(uint64_t data) {
+        TranspositionEntry entry;
+        entry.move.data = (uint16_t)data;
+        entry.score = (int32_t)(uint32_t)(data >> 16);
+        entry.depth = (int8_t)(uint8_t)(data >> 48);
+        entry.bound = (Bound)((data >> 56) & 3);
+        return entry;
+    }
+
+    [[nodiscard]] static int depth_of(uint64_t data) {
+        return (int8_t)(uint8_t)(data >> 48);
+    }
+
+    [[nodiscard]] static int generation_of(uint64_t data) {
+        return (int)(data >> 58);
+    }
+
+    [[nodiscard]] Cluster& cluster_for(uint64_t key) const {
+        return clusters[key & (cluster_count - 1)];
+    }
+
+    std::unique_ptr<Cluster[]> clusters;
+    size_t cluster_count;
+    std::atomic<int> generation;
+};
+
+#endif //CHESS_TRANSPOSITION_TABLE_H
@@ -9,6 +9,7 @@
 
 #include "constants.h"
 #include "data_types.h"
+#include "pure_states/evaluation.h"
 #include <SFML/Graphics.hpp>
 
 sf::Vector2f compute_piece_position(BoardPosition position, Side orientation);
@@ -27,16 +28,8 @@ std::vector<T> zip(const std::vector<T>& first, const std::vector<T>& second) {
     return result;
 }
 
-[[nodiscard]] static int get_piece_value(Pieces type) {
-    static std::map<Pieces, int> piece_values = {
-            {Pawn, 1},
-            {Knight, 5},
-            {Bishop, 5},
-            {Rook, 10},
-            {Queen, 25},
-            {King, 100},
-    };
-    return piece_values[type];
+[[nodiscard]] constexpr int get_piece_value(Pieces type) {
+    return evaluation::piece_values[type];
 }
 
 #endif //CHESS_UTILS_H
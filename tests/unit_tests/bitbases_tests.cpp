@@ -0,0 +1,194 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "pure_states/bitbases.h"
+#include "search/search.h"
+#include "scorers/material_scorer.h"
+
+/*
+ * KPK with KQK and KRK, which it needs. KBNK takes too long to generate for every test run.
+ */
+static std::shared_ptr<const Bitbases> small_bitbases() {
+    static auto bitbases = [] {
+        auto generated = std::make_shared<Bitbases>();
+        generated->generate({Bitbases::KPK});
+        return generated;
+    }();
+    return bitbases;
+}
+
+static std::optional<WinDrawLoss> probe(const std::string& fen) {
+    Board board;
+    Board::load_fen(board, fen);
+    return small_bitbases()->probe(board);
+}
+
+TEST(bitbases_tests, kpk) {
+    // The king on the sixth rank in front of its pawn wins whoever is to move.
+    EXPECT_EQ(Win, probe("4k3/8/4K3/4P3/8/8/8/8 w - - 0 1"));
+    EXPECT_EQ(Loss, probe("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1"));
+    // Behind it, it depends on who has the opposition.
+    EXPECT_EQ(Draw, probe("8/3k4/8/3K4/3P4/8/8/8 w - - 0 1"));
+    EXPECT_EQ(Loss, probe("8/3k4/8/3K4/3P4/8/8/8 b - - 0 1"));
+    // The defending king in front of the pawn.
+    EXPECT_EQ(Draw, probe("8/8/8/8/8/4k3/4P3/4K3 w - - 0 1"));
+    // A rook pawn with the defending king in the corner.
+    EXPECT_EQ(Draw, probe("k7/8/1K6/P7/8/8/8/8 w - - 0 1"));
+    // The pawn can't be caught.
+    EXPECT_EQ(Win, probe("8/8/8/P7/8/8/8/5k1K w - - 0 1"));
+    // Black's pawn is looked up with the board upside down.
+    EXPECT_EQ(Win, probe("8/8/8/8/4p3/4k3/8/4K3 b - - 0 1"));
+    EXPECT_EQ(Loss, probe("8/8/8/8/4p3/4k3/8/4K3 w - - 0 1"));
+}
+
+TEST(bitbases_tests, krk_and_kqk) {
+    EXPECT_EQ(Win, probe("8/8/8/3k4/8/8/8/R3K3 w - - 0 1"));
+    EXPECT_EQ(Loss, probe("8/8/8/3k4/8/8/8/R3K3 b - - 0 1"));
+    // The rook can be taken.
+    EXPECT_EQ(Draw, probe("8/8/8/8/8/8/1k6/1R4K1 b - - 0 1"));
+    // Stalemate.
+    EXPECT_EQ(Draw, probe("k7/2Q5/1K6/8/8/8/8/8 b - - 0 1"));
+    // Checkmate.
+    EXPECT_EQ(Loss, probe("k7/1Q6/1K6/8/8/8/8/8 b - - 0 1"));
+    EXPECT_EQ(Loss, probe("8/8/8/8/8/2k5/1q6/K7 w - - 0 1"));
+}
+
+TEST(bitbases_tests, other_material) {
+    EXPECT_EQ(Draw, probe("8/8/8/3k4/8/8/8/4K3 w - - 0 1"));
+    EXPECT_EQ(Draw, probe("8/8/8/3k4/8/8/8/2B1K3 w - - 0 1"));
+    EXPECT_EQ(Draw, probe("8/8/8/3k4/8/8/8/1N2K1N1 w - - 0 1"));
+    // Both sides with pieces, and too many pieces.
+    EXPECT_FALSE(probe("8/8/8/3k4/3p4/8/8/R3K3 w - - 0 1").has_value());
+    EXPECT_FALSE(probe("8/8/8/3k4/8/8/8/RR2K3 w - - 0 1").has_value());
+    EXPECT_FALSE(probe("8/8/8/3k4/8/8/8/RR2K1R1 w - - 0 1").has_value());
+    // KBNK wasn't generated.
+    EXPECT_FALSE(probe("8/8/8/3k4/8/8/8/1NB1K3 w - - 0 1").has_value());
+}
+
+/*
+ * A position is won if a move reaches one that is lost, and lost if it is checkmate or every move reaches one that is won.
+ */
+TEST(bitbases_tests, agrees_with_moves) {
+    auto bitbases = small_bitbases();
+    std::mt19937 random(22);
+    const char pieces[] = {'P', 'R', 'Q'};
+    int checked = 0;
+    while (checked < 3000) {
+        std::string squares(64, '.');
+        auto place = [&](char piece) {
+            while (true) {
+                int square = (int)(random() % 64);
+                if (squares[square] != '.' || (piece == 'P' && (square < 8 || square >= 56)))
+                    continue;
+                squares[square] = piece;
+                return;
+            }
+        };
+        place('K');
+        place('k');
+        place(pieces[random() % 3]);
+        std::string fen;
+        for (int row = 0; row < 8; row++) {
+            int empty = 0;
+            for (int column = 0; column < 8; column++) {
+                char piece = squares[row * 8 + column];
+                if (piece == '.') {
+                    empty++;
+                    continue;
+                }
+                if (empty)
+                    fen += std::to_string(empty);
+                empty = 0;
+                fen += piece;
+            }
+            if (empty)
+                fen += std::to_string(empty);
+            if (row < 7)
+                fen += '/';
+        }
+        Side side = random() % 2 ? White : Black;
+        fen += side == White ? " w - - 0 1" : " b - - 0 1";
+
+        Board board;
+        Board::load_fen(board, fen);
+        Side other = side == White ? Black : White;
+        auto white_king = square_position(first_square(board.get_piece_board(King, White)));
+        auto black_king = square_position(first_square(board.get_piece_board(King, Black)));
+        if (board.king_in_check(other) || (abs(white_king.row - black_king.row) <= 1 && abs(white_king.column - black_king.column) <= 1))
+            continue;
+
+        auto moves = board.legal_moves(side);
+        WinDrawLoss expected = moves.empty() && board.king_in_check(side) ? Loss : Draw;
+        if (!moves.empty())
+            expected = Loss;
+        for (const auto& move: moves) {
+            Board after = board;
+            after.move(move);
+            auto reply = bitbases->probe(after);
+            ASSERT_TRUE(reply.has_value()) << fen;
+            if (*reply == Loss)
+                expected = Win;
+            else if (*reply == Draw && expected == Loss)
+                expected = Draw;
+        }
+        ASSERT_EQ(expected, bitbases->probe(board)) << fen;
+        checked++;
+    }
+}
+
+TEST(bitbases_tests, save_and_load) {
+    auto path = (std::filesystem::temp_directory_path() / "bitbases_tests_krk.bitbase").string();
+    const auto& krk = small_bitbases()->endings[Bitbases::KRK];
+    ASSERT_TRUE(krk.save(path));
+    Bitbase loaded({Rook});
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(krk.wins, loaded.wins);
+
+    // The wrong size for the pieces.
+    Bitbase bishop_and_knight({Bishop, Knight});
+    EXPECT_FALSE(bishop_and_knight.load(path));
+    std::ofstream(path, std::ios::binary) << "not a bitbase";
+    EXPECT_FALSE(loaded.load(path));
+    EXPECT_EQ(krk.wins, loaded.wins);
+    std::filesystem::remove(path);
+}
+
+/*
+ * In each only one move keeps the win, which a search this shallow can't find by itself since the pawn is as far from queening after any move.
+ */
+TEST(bitbases_tests, search) {
+    const std::pair<const char*, Move> positions[] = {
+            {"8/8/5k2/8/8/4K3/6P1/8 w - - 0 1", Move({5, 4}, {4, 5})},
+            {"8/3K4/5k2/8/8/8/4P3/8 w - - 0 1", Move({1, 3}, {2, 3})},
+    };
+    for (const auto& [fen, winning]: positions) {
+        Board board;
+        Board::load_fen(board, fen);
+        Search search(std::make_shared<MaterialScorer>(), std::make_shared<TranspositionTable>(1));
+        search.options.pawn_value = 1;
+        search.bitbases = small_bitbases();
+        auto result = search.run(board, 4);
+        EXPECT_EQ(winning.current, result.move.current) << fen;
+        EXPECT_EQ(winning.next, result.move.next) << fen;
+        EXPECT_GE(result.score, Search::KNOWN_WIN_SCORE);
+        EXPECT_FALSE(Search::is_mate_score(result.score));
+        EXPECT_GT(result.stats.bitbase_hits, 0);
+    }
+
+    // A pawn up, but a draw.
+    Board board;
+    Board::load_fen(board, "8/8/8/8/8/4k3/4P3/4K3 w - - 0 1");
+    Search search(std::make_shared<MaterialScorer>(), std::make_shared<TranspositionTable>(1));
+    search.options.pawn_value = 1;
+    search.bitbases = small_bitbases();
+    EXPECT_EQ(0, search.run(board, 4).score);
+}
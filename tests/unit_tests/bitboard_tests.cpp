@@ -0,0 +1,34 @@
+//
+// Created by Chris Luttio on 1/13/22.
+//
+
+#include "gtest/gtest.h"
+#include "pure_states/bitboard.h"
+
+#include <random>
+
+TEST(bitboard_tests, magic_attacks_match_rays) {
+    std::mt19937_64 random(42);
+    for (int square = 0; square < 64; square++) {
+        for (int i = 0; i < 200; i++) {
+            Bitboard occupied = random() & random();
+            EXPECT_EQ(sliding_attacks(square, occupied, rook_directions), rook_attacks(square, occupied));
+            EXPECT_EQ(sliding_attacks(square, occupied, bishop_directions), bishop_attacks(square, occupied));
+        }
+    }
+}
+
+TEST(bitboard_tests, leaper_attacks) {
+    EXPECT_EQ(8, count_squares(knight_attacks[square_index(4, 4)]));
+    EXPECT_EQ(2, count_squares(knight_attacks[square_index(0, 0)]));
+    EXPECT_EQ(3, count_squares(king_attacks[square_index(7, 7)]));
+    EXPECT_EQ(square_bit(square_index(5, 1)), pawn_attacks[White][square_index(6, 0)]);
+    EXPECT_EQ(square_bit(square_index(2, 6)), pawn_attacks[Black][square_index(1, 7)]);
+}
+
+TEST(bitboard_tests, squares_between) {
+    EXPECT_EQ(square_bit(square_index(7, 5)) | square_bit(square_index(7, 6)), squares_between[square_index(7, 4)][square_index(7, 7)]);
+    EXPECT_EQ(square_bit(square_index(1, 1)), squares_between[square_index(0, 0)][square_index(2, 2)]);
+    EXPECT_EQ(0, squares_between[square_index(0, 0)][square_index(1, 2)]);
+    EXPECT_EQ(0, squares_between[square_index(3, 3)][square_index(3, 4)]);
+}
@@ -5,6 +5,9 @@
 #include "gtest/gtest.h"
 #include "pure_states/board.h"
 
+#include <set>
+#include <tuple>
+
 TEST(board_tests, defaults) {
     Board board;
 
@@ -1205,3 +1208,408 @@ TEST(board_tests, stalemate) {
     EXPECT_FALSE(b2.checkmate());
     EXPECT_TRUE(b2.stalemate(White));
 }
+
+TEST(board_tests, bitboards) {
+    Board board;
+    Board::setup(board);
+
+    EXPECT_EQ(32, count_squares(board.occupied()));
+    EXPECT_EQ(16, count_squares(board.side_boards[White]));
+    EXPECT_EQ(8, count_squares(board.get_piece_board(Pawn, Black)));
+    EXPECT_EQ(square_bit(BoardPosition{7, 4}), board.get_piece_board(King, White));
+
+    board.move({{6, 4}, {4, 4}, Pawn_DoubleMove});
+
+    EXPECT_FALSE(board.occupied() & square_bit(BoardPosition{6, 4}));
+    EXPECT_TRUE(board.get_piece_board(Pawn, White) & square_bit(BoardPosition{4, 4}));
+
+    board.set_piece_at({4, 4}, {Knight, Black});
+
+    EXPECT_FALSE(board.piece_boards[Pawn] & square_bit(BoardPosition{4, 4}));
+    EXPECT_TRUE(board.get_piece_board(Knight, Black) & square_bit(BoardPosition{4, 4}));
+    EXPECT_EQ(15, count_squares(board.side_boards[White]));
+
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            auto piece = board.get_piece_at(y, x);
+            auto bit = square_bit(BoardPosition{y, x});
+            EXPECT_EQ(piece.type != None, (board.occupied() & bit) != 0);
+            if (piece.type != None) {
+                EXPECT_TRUE(board.get_piece_board(piece.type, piece.side) & bit);
+            }
+        }
+    }
+}
+
+static void expect_same_board(const Board& a, const Board& b) {
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            EXPECT_EQ(a.get_piece_at(y, x).type, b.get_piece_at(y, x).type);
+            EXPECT_EQ(a.get_piece_at(y, x).side, b.get_piece_at(y, x).side);
+            EXPECT_EQ(a.get_piece_at(y, x).id, b.get_piece_at(y, x).id);
+        }
+    }
+    EXPECT_EQ(a.piece_boards, b.piece_boards);
+    EXPECT_EQ(a.side_boards, b.side_boards);
+    EXPECT_EQ(a.moves.size(), b.moves.size());
+    EXPECT_EQ(a.castled(White), b.castled(White));
+    EXPECT_EQ(a.castled(Black), b.castled(Black));
+    for (auto side: {White, Black})
+        EXPECT_EQ(a.kings[side], b.kings[side]);
+}
+
+TEST(board_tests, make_unmake_move) {
+    Board board;
+
+    board.set_piece_at({7, 4}, {King, White});
+    board.set_piece_at({7, 7}, {Rook, White});
+    board.set_piece_at({7, 0}, {Rook, White});
+    board.set_piece_at({1, 1}, {Pawn, White});
+    board.set_piece_at({0, 0}, {Knight, Black});
+    board.set_piece_at({3, 3}, {Pawn, White});
+    board.set_piece_at({1, 4}, {Pawn, Black});
+    board.set_piece_at({0, 4}, {King, Black});
+
+    std::vector<Move> moves{
+        {{7, 4}, {7, 6}},
+        {{7, 4}, {7, 2}},
+        {{1, 1}, {0, 1}},
+        {{1, 1}, {0, 0}},
+        {{7, 0}, {0, 0}},
+        {{7, 4}, {6, 4}},
+    };
+
+    for (auto move: moves) {
+        Board before = board;
+        ASSERT_TRUE(board.legal(move));
+        auto undo = board.make_move(move);
+        EXPECT_EQ(before.moves.size() + 1, board.moves.size());
+        board.unmake_move(undo);
+        expect_same_board(before, board);
+    }
+
+    board.move(board.classify_move({{1, 4}, {3, 4}}));
+    Board before = board;
+    Move en_passant {{3, 3}, {2, 4}};
+    ASSERT_TRUE(board.legal(en_passant));
+    EXPECT_EQ(Pawn_EnPassant, en_passant.type);
+    auto undo = board.make_move(en_passant);
+    EXPECT_EQ(None, board.get_piece_at(3, 4).type);
+    board.unmake_move(undo);
+    expect_same_board(before, board);
+}
+
+TEST(board_tests, legal_without_copy) {
+    Board board;
+
+    board.set_piece_at({7, 4}, {King, White});
+    board.set_piece_at({6, 4}, {Bishop, White});
+    board.set_piece_at({0, 4}, {Rook, Black});
+
+    Move pinned {{6, 4}, {5, 5}};
+    EXPECT_FALSE(board.legal(pinned));
+
+    board.set_piece_at({3, 1}, {Pawn, White});
+    board.set_piece_at({3, 2}, {Pawn, Black});
+    board.set_piece_at({3, 7}, {King, White});
+    board.set_piece_at({7, 4});
+    board.set_piece_at({3, 0}, {Rook, Black});
+    board.moves.push_back(Move{{1, 2}, {3, 2}, Pawn_DoubleMove});
+
+    // Taking en passant would open the row to the rook.
+    Move en_passant {{3, 1}, {2, 2}};
+    EXPECT_FALSE(board.legal(en_passant));
+}
+
+/*
+ * Every move legal() accepts, found by trying every pair of squares.
+ */
+static std::set<std::tuple<int, int, int, int, int>> brute_force_moves(const Board& board, Side side) {
+    std::set<std::tuple<int, int, int, int, int>> found;
+    for (const auto& from: board.get_pieces(side)) {
+        for (int y = 0; y < 8; y++) {
+            for (int x = 0; x < 8; x++) {
+                Move move {from, {y, x}};
+                if (board.legal(move))
+                    found.insert({from.row, from.column, y, x, move.type});
+            }
+        }
+    }
+    return found;
+}
+
+TEST(board_tests, legal_moves_matches_legal) {
+    srand(7);
+    for (int game = 0; game < 20; game++) {
+        Board board;
+        Board::setup(board);
+        Side side = White;
+        for (int ply = 0; ply < 80; ply++) {
+            auto moves = board.legal_moves(side);
+            std::set<std::tuple<int, int, int, int, int>> generated;
+            for (const auto& move: moves)
+                generated.insert({move.current.row, move.current.column, move.next.row, move.next.column, move.type});
+            ASSERT_EQ(brute_force_moves(board, side), generated);
+            if (moves.empty())
+                break;
+            board.move(moves[rand() % moves.size()]);
+            side = side == White ? Black : White;
+        }
+    }
+}
+
+TEST(board_tests, legal_moves_promotions) {
+    Board board;
+
+    board.set_piece_at({1, 1}, {Pawn, White});
+    board.set_piece_at({0, 2}, {Rook, Black});
+    board.set_piece_at({0, 1}, {Knight, Black});
+
+    auto moves = board.legal_moves(White);
+    EXPECT_EQ(4, moves.size());
+    for (const auto& move: moves) {
+        EXPECT_EQ(Pawn_Promotion, move.type);
+        EXPECT_EQ(0, move.next.row);
+        EXPECT_EQ(2, move.next.column);
+    }
+
+    // Into a list that already holds moves, which are replaced.
+    board.legal_moves(Black, moves);
+    EXPECT_EQ(board.legal_moves(Black).size(), moves.size());
+    for (const auto& move: moves)
+        EXPECT_EQ(Black, board.get_piece_at(move.current).side);
+
+    Move capture {{1, 1}, {0, 2}};
+    EXPECT_TRUE(board.legal(capture));
+    EXPECT_EQ(Pawn_Promotion, capture.type);
+    capture.promotion = Knight;
+    board.move(capture);
+    EXPECT_EQ(Knight, board.get_piece_at(0, 2).type);
+    EXPECT_EQ(White, board.get_piece_at(0, 2).side);
+}
+
+TEST(board_tests, legal_moves_check_evasions) {
+    Board board;
+
+    board.set_piece_at({7, 4}, {King, White});
+    board.set_piece_at({7, 0}, {Rook, White});
+    board.set_piece_at({5, 2}, {Knight, White});
+    board.set_piece_at({0, 4}, {Rook, Black});
+
+    // Double check, only the king can move.
+    board.set_piece_at({5, 3}, {Knight, Black});
+    auto moves = board.legal_moves(White);
+    EXPECT_FALSE(moves.empty());
+    for (const auto& move: moves)
+        EXPECT_EQ(King, board.get_piece_at(move.current).type);
+
+    // Single check, the other pieces can only block on the rook's column.
+    board.set_piece_at({5, 3});
+    int blocks = 0;
+    for (const auto& move: board.legal_moves(White)) {
+        if (board.get_piece_at(move.current).type != King) {
+            EXPECT_EQ(4, move.next.column);
+            blocks++;
+        }
+    }
+    EXPECT_EQ(2, blocks);
+}
+
+TEST(board_tests, castling_rights) {
+    Board board;
+    Board::setup(board);
+
+    EXPECT_EQ(WhiteKingSide | WhiteQueenSide | BlackKingSide | BlackQueenSide, board.castling_rights());
+
+    board.move(board.classify_move({{6, 7}, {4, 7}}));
+    board.move(board.classify_move({{1, 0}, {3, 0}}));
+    board.move(board.classify_move({{7, 7}, {5, 7}}));
+
+    EXPECT_EQ(WhiteQueenSide | BlackKingSide | BlackQueenSide, board.castling_rights());
+    EXPECT_TRUE(board.moved(board.get_piece_at(5, 7)));
+
+    board.move(board.classify_move({{0, 0}, {2, 0}}));
+    board.move(board.classify_move({{5, 7}, {7, 7}}));
+
+    EXPECT_EQ(WhiteQueenSide | BlackKingSide, board.castling_rights());
+
+    board.move(board.classify_move({{1, 4}, {2, 4}}));
+    board.move(board.classify_move({{6, 4}, {5, 4}}));
+    board.move(board.classify_move({{0, 4}, {1, 4}}));
+
+    EXPECT_EQ(WhiteQueenSide, board.castling_rights());
+
+    Board fresh;
+    Board::setup(fresh);
+    auto pawn_undo = fresh.make_move(fresh.classify_move({{6, 4}, {4, 4}}));
+    EXPECT_TRUE(fresh.moved(fresh.get_piece_at(4, 4)));
+    fresh.unmake_move(pawn_undo);
+    EXPECT_FALSE(fresh.moved(fresh.get_piece_at(6, 4)));
+    EXPECT_EQ(0, fresh.moved_pieces);
+}
+
+TEST(board_tests, packed_move_round_trip) {
+    srand(11);
+    for (int game = 0; game < 10; game++) {
+        Board board;
+        Board::setup(board);
+        Side side = White;
+        for (int ply = 0; ply < 120; ply++) {
+            auto moves = board.legal_moves(side);
+            if (moves.empty())
+                break;
+            for (const auto& move: moves) {
+                auto unpacked = board.unpack_move(PackedMove(move));
+                ASSERT_EQ(move.current, unpacked.current);
+                ASSERT_EQ(move.next, unpacked.next);
+                ASSERT_EQ(move.type, unpacked.type);
+                ASSERT_EQ(move.promotion, unpacked.promotion);
+                ASSERT_EQ(move.piece_id, unpacked.piece_id);
+                ASSERT_EQ(move.piece_type, unpacked.piece_type);
+            }
+            board.move(moves[rand() % moves.size()]);
+            side = side == White ? Black : White;
+        }
+    }
+}
+
+TEST(board_tests, packed_move_flags) {
+    for (auto type: {Unclassified, Pawn_Move, Pawn_Attack, Pawn_DoubleMove, Pawn_EnPassant, Rook_Move, Knight_Move,
+                     Bishop_Move, Queen_Move, King_Move, King_KingSideCastle, King_QueenSideCastle}) {
+        PackedMove packed(Move({7, 7}, {0, 0}, type));
+        EXPECT_EQ(type, packed.type());
+        EXPECT_EQ(Queen, packed.promotion());
+        EXPECT_EQ((BoardPosition{7, 7}), packed.from());
+        EXPECT_EQ((BoardPosition{0, 0}), packed.to());
+    }
+    for (auto piece: {Rook, Bishop, Knight, Queen}) {
+        Move move({1, 3}, {0, 3}, Pawn_Promotion);
+        move.promotion = piece;
+        PackedMove packed(move);
+        EXPECT_EQ(Pawn_Promotion, packed.type());
+        EXPECT_EQ(piece, packed.promotion());
+    }
+    EXPECT_TRUE(PackedMove().empty());
+}
+
+TEST(board_tests, zobrist_key_matches_recomputation) {
+    Board empty;
+    EXPECT_EQ(0, empty.key);
+    EXPECT_EQ(empty.compute_key(), empty.key);
+
+    srand(13);
+    for (int game = 0; game < 20; game++) {
+        Board board;
+        Board::setup(board);
+        ASSERT_EQ(board.compute_key(), board.key);
+        for (int ply = 0; ply < 120; ply++) {
+            auto moves = board.legal_moves(board.side_to_move());
+            if (moves.empty())
+                break;
+            for (const auto& move: moves) {
+                auto before = board.key;
+                auto undo = board.make_move(move);
+                ASSERT_EQ(board.compute_key(), board.key);
+                board.unmake_move(undo);
+                ASSERT_EQ(before, board.key);
+            }
+            board.move(moves[rand() % moves.size()]);
+            ASSERT_EQ(board.compute_key(), board.key);
+        }
+    }
+}
+
+TEST(board_tests, evaluation_totals_match_recomputation) {
+    Board empty;
+    EXPECT_EQ(evaluation::Totals{}, empty.totals);
+
+    Board start;
+    Board::setup(start);
+    EXPECT_EQ(start.compute_totals(), start.totals);
+    EXPECT_EQ(start.totals.material[White], start.totals.material[Black]);
+    EXPECT_EQ(evaluation::MAX_PHASE, start.totals.phase);
+    EXPECT_EQ(0, start.totals.positional(White));
+
+    srand(17);
+    for (int game = 0; game < 20; game++) {
+        Board board;
+        Board::setup(board);
+        for (int ply = 0; ply < 120; ply++) {
+            auto moves = board.legal_moves(board.side_to_move());
+            if (moves.empty())
+                break;
+            for (const auto& move: moves) {
+                auto before = board.totals;
+                auto undo = board.make_move(move);
+                ASSERT_EQ(board.compute_totals(), board.totals);
+                board.unmake_move(undo);
+                ASSERT_EQ(before, board.totals);
+            }
+            board.move(moves[rand() % moves.size()]);
+            ASSERT_EQ(board.compute_totals(), board.totals);
+        }
+    }
+
+    // Promotions, castling and en passant.
+    Board special;
+    Board::load_fen(special, "r3k2r/1P6/8/3pP3/8/8/8/R3K2R w KQkq d6 0 1");
+    EXPECT_EQ(special.compute_totals(), special.totals);
+    for (auto move: special.legal_moves(White)) {
+        auto undo = special.make_move(move);
+        ASSERT_EQ(special.compute_totals(), special.totals);
+        special.unmake_move(undo);
+    }
+    auto promotion = special.classify_move({{1, 1}, {0, 0}});
+    promotion.promotion = Queen;
+    auto material = special.totals.material[White];
+    special.move(promotion);
+    EXPECT_EQ(material + evaluation::piece_values[Queen] - evaluation::piece_values[Pawn], special.totals.material[White]);
+    EXPECT_EQ(special.compute_totals(), special.totals);
+}
+
+TEST(board_tests, null_move) {
+    Board board;
+    Board::load_fen(board, "4k3/8/8/8/3pP3/8/8/4K3 b - e3 0 1");
+    EXPECT_EQ(square_index(5, 4), board.en_passant_square());
+    auto before = board.key;
+
+    auto undo = board.make_null_move();
+    EXPECT_EQ(White, board.side_to_move());
+    EXPECT_EQ(-1, board.en_passant_square());
+    EXPECT_EQ(board.compute_key(), board.key);
+    EXPECT_NE(before, board.key);
+    EXPECT_EQ(6, board.legal_moves(White).size());
+
+    board.unmake_null_move(undo);
+    EXPECT_EQ(Black, board.side_to_move());
+    EXPECT_EQ(square_index(5, 4), board.en_passant_square());
+    EXPECT_EQ(before, board.key);
+}
+
+TEST(board_tests, zobrist_key_identifies_position) {
+    Board a, b;
+    Board::setup(a);
+    Board::setup(b);
+    EXPECT_EQ(a.key, b.key);
+
+    // The same position reached by different move orders.
+    for (const auto& [from, to]: std::vector<std::pair<BoardPosition, BoardPosition>>{{{7, 6}, {5, 5}}, {{0, 6}, {2, 5}}, {{7, 1}, {5, 2}}})
+        a.move(a.classify_move({from, to}));
+    for (const auto& [from, to]: std::vector<std::pair<BoardPosition, BoardPosition>>{{{7, 1}, {5, 2}}, {{0, 6}, {2, 5}}, {{7, 6}, {5, 5}}})
+        b.move(b.classify_move({from, to}));
+    EXPECT_EQ(a.key, b.key);
+
+    // Only the side to move differs.
+    Board white, black;
+    Board::load_fen(white, "4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+    Board::load_fen(black, "4k3/8/8/8/8/8/8/4K3 b - - 0 1");
+    EXPECT_NE(white.key, black.key);
+    EXPECT_EQ(black.compute_key(), black.key);
+
+    // Only the castling rights differ.
+    Board castle, no_castle;
+    Board::load_fen(castle, "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    Board::load_fen(no_castle, "r3k2r/8/8/8/8/8/8/R3K2R w Kkq - 0 1");
+    EXPECT_NE(castle.key, no_castle.key);
+    EXPECT_EQ(no_castle.compute_key(), no_castle.key);
+}
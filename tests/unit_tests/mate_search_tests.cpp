@@ -0,0 +1,140 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "search/mate_search.h"
+#include "players/smart_ai_player.h"
+
+static MateResult solve(const std::string& fen, int moves, bool checks_only = false) {
+    Board board;
+    Board::load_fen(board, fen);
+    MateSearch search;
+    search.checks_only = checks_only;
+    return search.solve(board, moves);
+}
+
+static void expect_line(const std::vector<Move>& line, const std::vector<std::pair<BoardPosition, BoardPosition>>& expected) {
+    ASSERT_EQ(expected.size(), line.size());
+    for (size_t i = 0; i < line.size(); i++) {
+        EXPECT_EQ(expected[i].first, line[i].current) << i;
+        EXPECT_EQ(expected[i].second, line[i].next) << i;
+    }
+}
+
+TEST(mate_search_tests, mate_in_one) {
+    auto result = solve("r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4", 3);
+    EXPECT_EQ(Proven, result.proof);
+    EXPECT_EQ(1, result.moves);
+    expect_line(result.line, {{{3, 7}, {1, 5}}});
+}
+
+TEST(mate_search_tests, mate_in_two) {
+    // Nf6+ gxf6 Bxf7#
+    auto result = solve("r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1", 3);
+    EXPECT_EQ(Proven, result.proof);
+    EXPECT_EQ(2, result.moves);
+    expect_line(result.line, {{{3, 3}, {2, 5}}, {{1, 6}, {2, 5}}, {{4, 2}, {1, 5}}});
+
+    // Qd5+ Ka6 cxb8=N#
+    result = solve("1rb4r/pkPp3p/1b1P3n/1Q6/N3Pp2/8/P1P3PP/7K w - - 1 1", 3);
+    EXPECT_EQ(Proven, result.proof);
+    EXPECT_EQ(2, result.moves);
+    ASSERT_EQ(3, result.line.size());
+    EXPECT_EQ(Pawn_Promotion, result.line[2].type);
+    EXPECT_EQ(Knight, result.line[2].promotion);
+}
+
+TEST(mate_search_tests, mate_in_three) {
+    // Black mates: Bc5+ Kxc5 Qb6+ Kd5 Qd6#
+    auto result = solve("r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1", 3);
+    EXPECT_EQ(Proven, result.proof);
+    EXPECT_EQ(3, result.moves);
+    expect_line(result.line, {{{0, 5}, {3, 2}}, {{4, 3}, {3, 2}}, {{2, 5}, {2, 1}}, {{3, 2}, {3, 3}}, {{2, 1}, {2, 3}}});
+}
+
+TEST(mate_search_tests, no_mate) {
+    // King and queen need four moves from here.
+    auto result = solve("8/8/8/8/8/2k5/8/1K1Q4 w - - 0 1", 3);
+    EXPECT_EQ(Disproven, result.proof);
+    EXPECT_TRUE(result.line.empty());
+    result = solve("8/8/8/8/8/2k5/8/1K1Q4 w - - 0 1", 4);
+    EXPECT_EQ(Proven, result.proof);
+    EXPECT_EQ(4, result.moves);
+    EXPECT_EQ(7, result.line.size());
+
+    // Kb6 takes every square from the king, but it's stalemate.
+    EXPECT_EQ(Disproven, solve("k7/2Q5/8/1K6/8/8/8/8 w - - 0 1", 1).proof);
+}
+
+TEST(mate_search_tests, checks_only) {
+    // Kc7 first is quiet.
+    EXPECT_EQ(Proven, solve("k7/8/2K5/8/8/8/8/7R w - - 0 1", 2).proof);
+    EXPECT_EQ(Disproven, solve("k7/8/2K5/8/8/8/8/7R w - - 0 1", 2, true).proof);
+    auto result = solve("r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1", 3, true);
+    EXPECT_EQ(Proven, result.proof);
+    EXPECT_EQ(3, result.moves);
+}
+
+TEST(mate_search_tests, out_of_nodes) {
+    Board board;
+    Board::setup(board);
+    MateSearch search;
+    search.max_nodes = 1000;
+    auto result = search.solve(board, 3);
+    EXPECT_EQ(Unproven, result.proof);
+    EXPECT_GT(result.nodes, 0);
+}
+
+TEST(mate_search_tests, king_exposed) {
+    Board board;
+    Board::setup(board);
+    EXPECT_FALSE(MateSearch::king_exposed(board));
+    Board queen;
+    Board::load_fen(queen, "8/8/8/8/8/2k5/8/1K1Q4 w - - 0 1");
+    EXPECT_TRUE(MateSearch::king_exposed(queen));
+}
+
+/*
+ * The search alone, a ply deep, would never give up the bishop.
+ */
+TEST(mate_search_tests, smart_ai_player) {
+    Board board;
+    Board::load_fen(board, "r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1");
+    SmartAIPlayer player(Black, 1, 1);
+    player.mate_search_moves = 3;
+    auto result = player.search(board);
+    EXPECT_EQ((BoardPosition{0, 5}), result.move.current);
+    EXPECT_EQ((BoardPosition{3, 2}), result.move.next);
+    EXPECT_EQ(Search::MATE_SCORE - 5, result.score);
+    EXPECT_EQ(5, result.pv.size());
+}
+
+/*
+ * Off the clock the mate search runs to the end, but stopping the player still ends it.
+ */
+TEST(mate_search_tests, smart_ai_player_stop) {
+    Board board;
+    Board::load_fen(board, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    ASSERT_TRUE(MateSearch::king_exposed(board));
+    SmartAIPlayer player(White, 1, 1);
+    player.mate_search_moves = 8;
+
+    std::atomic<bool> cancel{false};
+    auto start = std::chrono::steady_clock::now();
+    std::thread stopper([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        cancel = true;
+    });
+    auto result = player.search(board, &cancel);
+    stopper.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    EXPECT_TRUE(board.legal(result.move));
+}
@@ -0,0 +1,172 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "search/opening_book.h"
+#include "players/smart_ai_player.h"
+
+static std::string book_path(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static Move classified(const Board& board, Move move) {
+    EXPECT_TRUE(board.legal(move));
+    return move;
+}
+
+TEST(opening_book_tests, probe) {
+    Board start;
+    Board::setup(start);
+    Board after_e4 = start;
+    after_e4.move(classified(start, Move({6, 4}, {4, 4})));
+
+    Move e4 = classified(start, Move({6, 4}, {4, 4}));
+    Move d4 = classified(start, Move({6, 3}, {4, 3}));
+    Move c5 = classified(after_e4, Move({1, 2}, {3, 2}));
+    std::vector<BookEntry> entries{
+            {OpeningBook::key(start), OpeningBook::encode(e4), 3, 0},
+            {OpeningBook::key(start), OpeningBook::encode(d4), 1, 0},
+            {OpeningBook::key(after_e4), OpeningBook::encode(c5), 1, 0},
+            // Other positions around them in the file.
+            {1, 0, 1, 0},
+            {~uint64_t{0}, 0, 1, 0},
+    };
+    auto path = book_path("opening_book_tests_probe.bin");
+    ASSERT_TRUE(OpeningBook::write(path, entries));
+
+    OpeningBook book;
+    ASSERT_TRUE(book.open(path));
+    EXPECT_EQ(5, book.size());
+
+    auto moves = book.moves(start);
+    ASSERT_EQ(2, moves.size());
+    EXPECT_EQ(PackedMove(e4), PackedMove(moves[0].move));
+    EXPECT_EQ(3, moves[0].weight);
+    EXPECT_EQ(PackedMove(d4), PackedMove(moves[1].move));
+    EXPECT_EQ(Pawn_DoubleMove, moves[0].move.type);
+
+    // Picks by weight, three in four are e4.
+    int e4_picks = 0;
+    for (uint32_t random = 0; random < 400; random++)
+        e4_picks += PackedMove(*book.pick(start, random)) == PackedMove(e4);
+    EXPECT_EQ(300, e4_picks);
+
+    EXPECT_EQ(PackedMove(c5), PackedMove(*book.pick(after_e4, 7)));
+
+    Board out_of_book = after_e4;
+    out_of_book.move(c5);
+    EXPECT_FALSE(book.pick(out_of_book, 0).has_value());
+
+    std::filesystem::remove(path);
+}
+
+TEST(opening_book_tests, bad_files) {
+    OpeningBook book;
+    EXPECT_FALSE(book.open(book_path("opening_book_tests_missing.bin")));
+
+    auto path = book_path("opening_book_tests_truncated.bin");
+    std::ofstream(path, std::ios::binary) << "not a book";
+    EXPECT_FALSE(book.open(path));
+    EXPECT_FALSE(book.is_open());
+
+    Board board;
+    Board::setup(board);
+    EXPECT_TRUE(book.moves(board).empty());
+    std::filesystem::remove(path);
+}
+
+TEST(opening_book_tests, move_encoding) {
+    // e2e4 from a1 = 0: to e4 = 28, from e2 = 12.
+    EXPECT_EQ(28 | (12 << 6), OpeningBook::encode(Move({6, 4}, {4, 4}, Pawn_DoubleMove)));
+
+    Board board;
+    Board::load_fen(board, "r3k2r/1P6/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    Move castle = classified(board, Move({7, 4}, {7, 6}));
+    ASSERT_EQ(King_KingSideCastle, castle.type);
+    // Written as the king taking the rook on h1.
+    EXPECT_EQ(7 | (4 << 6), OpeningBook::encode(castle));
+    EXPECT_EQ(King_KingSideCastle, OpeningBook::decode(board, OpeningBook::encode(castle)).type);
+    Move long_castle = classified(board, Move({7, 4}, {7, 2}));
+    EXPECT_EQ(King_QueenSideCastle, OpeningBook::decode(board, OpeningBook::encode(long_castle)).type);
+
+    Move promotion({1, 1}, {0, 0});
+    promotion.promotion = Knight;
+    promotion = classified(board, promotion);
+    auto decoded = OpeningBook::decode(board, OpeningBook::encode(promotion));
+    EXPECT_EQ(Pawn_Promotion, decoded.type);
+    EXPECT_EQ(Knight, decoded.promotion);
+    // Only 0 to 4 are promotion pieces.
+    EXPECT_EQ(Unclassified, OpeningBook::decode(board, OpeningBook::encode(promotion) | (7 << 12)).type);
+
+    EXPECT_EQ(Unclassified, OpeningBook::decode(board, OpeningBook::encode(Move({7, 0}, {0, 1}))).type);
+}
+
+TEST(opening_book_tests, key) {
+    Board a, b;
+    Board::load_fen(a, "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+    Board::load_fen(b, "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+    // No black pawn can take on e3, so the en passant square doesn't change the key.
+    EXPECT_EQ(OpeningBook::key(a), OpeningBook::key(b));
+
+    Board c, d;
+    Board::load_fen(c, "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+    Board::load_fen(d, "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+    EXPECT_NE(OpeningBook::key(c), OpeningBook::key(d));
+
+    Board e, f;
+    Board::load_fen(e, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    Board::load_fen(f, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w Kkq - 0 1");
+    EXPECT_NE(OpeningBook::key(e), OpeningBook::key(f));
+}
+
+/*
+ * The keys given with the Polyglot book format, for the start position and the positions after e4 d5 e5 f5 Ke2 Kf7
+ * and after a4 b5 h4 b4 c4 bxc3 Ra3.
+ */
+TEST(opening_book_tests, polyglot_keys) {
+    const std::vector<std::pair<std::string, uint64_t>> positions{
+            {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463b96181691fc9c},
+            {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823c9b50fd114196},
+            {"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756b94461c50fb0},
+            {"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662fafb965db29d4},
+            {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22a48b5a8e47ff78},
+            {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652a607ca3f242c1},
+            {"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00fdd303c946bdd9},
+            {"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3c8123ea7b067637},
+            {"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5c3f9b829b279560},
+    };
+    for (const auto& [fen, key]: positions) {
+        Board board;
+        ASSERT_TRUE(Board::load_fen(board, fen));
+        EXPECT_EQ(key, OpeningBook::key(board)) << fen;
+    }
+
+    Board start;
+    Board::setup(start);
+    EXPECT_EQ(0x463b96181691fc9c, OpeningBook::key(start));
+}
+
+TEST(opening_book_tests, smart_ai_plays_book_moves) {
+    Board board;
+    Board::setup(board);
+    Move d4 = classified(board, Move({6, 3}, {4, 3}));
+    auto path = book_path("opening_book_tests_player.bin");
+    ASSERT_TRUE(OpeningBook::write(path, {{OpeningBook::key(board), OpeningBook::encode(d4), 1, 0}}));
+
+    SmartAIPlayer player(White, 4, 1);
+    player.book = std::make_shared<OpeningBook>();
+    ASSERT_TRUE(player.book->open(path));
+    EXPECT_EQ(PackedMove(d4), PackedMove(player.move(board)));
+
+    board.move(d4);
+    auto reply = player.move(board);
+    EXPECT_TRUE(board.legal(reply));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,61 @@
+//
+// Created by Chris Luttio on 1/14/22.
+//
+
+#include "gtest/gtest.h"
+
+#include "pure_states/perft.h"
+
+TEST(perft_tests, reference_positions) {
+    for (const auto& position: perft_positions) {
+        Board board;
+        ASSERT_TRUE(Board::load_fen(board, position.fen)) << position.name;
+        for (int depth = 1; depth <= 3; depth++)
+            EXPECT_EQ(position.nodes[depth - 1], perft(board, depth)) << position.name << " depth " << depth;
+    }
+}
+
+TEST(perft_tests, divide_adds_up) {
+    Board board;
+    Board::load_fen(board, perft_positions[1].fen);
+    auto counts = perft_divide(board, 3);
+    EXPECT_EQ(48, counts.size());
+    uint64_t nodes = 0;
+    for (const auto& [move, count]: counts)
+        nodes += count;
+    EXPECT_EQ(perft_positions[1].nodes[2], nodes);
+}
+
+TEST(perft_tests, load_fen) {
+    Board board;
+    ASSERT_TRUE(Board::load_fen(board, "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b Kq e3 0 3"));
+
+    EXPECT_EQ(Black, board.side_to_move());
+    EXPECT_EQ(Pawn, board.get_piece_at(4, 4).type);
+    EXPECT_EQ(White, board.get_piece_at(4, 4).side);
+    EXPECT_EQ(square_index(5, 4), board.en_passant_square());
+    EXPECT_EQ(WhiteKingSide | BlackQueenSide, board.castling_rights());
+
+    Board start;
+    ASSERT_TRUE(Board::load_fen(start, perft_positions[0].fen));
+    Board setup;
+    Board::setup(setup);
+    EXPECT_EQ(setup.piece_boards, start.piece_boards);
+    EXPECT_EQ(setup.side_boards, start.side_boards);
+    EXPECT_EQ(White, start.side_to_move());
+
+    Board bad;
+    EXPECT_FALSE(Board::load_fen(bad, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1"));
+    EXPECT_FALSE(Board::load_fen(bad, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1"));
+}
+
+TEST(perft_tests, parallel_matches_reference) {
+    for (int threads: {1, 4}) {
+        for (const auto& position: perft_positions) {
+            Board board;
+            Board::load_fen(board, position.fen);
+            PerftTable table(1);
+            EXPECT_EQ(position.nodes[3], perft_parallel(board, 4, threads, table)) << position.name << " " << threads << " threads";
+        }
+    }
+}
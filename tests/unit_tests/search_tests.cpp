@@ -0,0 +1,460 @@
+//
+// Created by Chris Luttio on 1/16/22.
+//
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "search/search.h"
+#include "players/smart_ai_player.h"
+#include "players/autonomous_player.h"
+#include "pure_states/perft.h"
+#include "pure_states/see.h"
+#include "scorers/material_scorer.h"
+
+static bool is_legal(const Board& board, Move move) {
+    return board.legal(move);
+}
+
+static int minimax(Board& board, const Scorer& scorer, int depth, int ply) {
+    Side side = board.side_to_move();
+    auto moves = board.legal_moves(side);
+    bool in_check = board.king_in_check(side);
+    if (moves.empty())
+        return in_check ? -Search::MATE_SCORE + ply : 0;
+    int best = -Search::INFINITE_SCORE;
+    if (depth <= 0) {
+        // Quiescence without alpha-beta: standing pat or any capture that doesn't lose material or queen promotion, every move in check.
+        if (!in_check)
+            best = scorer.score(board, side) - scorer.score(board, side == White ? Black : White);
+        for (const auto& move: moves) {
+            if (!in_check && (MoveOrdering::is_quiet(board, move) || (move.type == Pawn_Promotion && move.promotion != Queen)
+                              || static_exchange(board, move) < 0))
+                continue;
+            auto undo = board.make_move(move);
+            best = std::max(best, -minimax(board, scorer, 0, ply + 1));
+            board.unmake_move(undo);
+        }
+        return best;
+    }
+    for (const auto& move: moves) {
+        auto undo = board.make_move(move);
+        best = std::max(best, -minimax(board, scorer, depth - 1, ply + 1));
+        board.unmake_move(undo);
+    }
+    return best;
+}
+
+static Search make_search() {
+    Search search(std::make_shared<MaterialScorer>(), std::make_shared<TranspositionTable>(1));
+    search.options.pawn_value = 1;
+    return search;
+}
+
+TEST(search_tests, mate_in_one) {
+    Board board;
+    Board::load_fen(board, "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    auto search = make_search();
+    auto result = search.run(board, 3);
+    EXPECT_EQ((BoardPosition{7, 0}), result.move.current);
+    EXPECT_EQ((BoardPosition{0, 0}), result.move.next);
+    EXPECT_EQ(Search::MATE_SCORE - 1, result.score);
+}
+
+TEST(search_tests, mate_in_two) {
+    Board board;
+    Board::load_fen(board, "k7/8/2K5/8/8/8/8/7R w - - 0 1");
+    auto search = make_search();
+    auto result = search.run(board, 4);
+    EXPECT_EQ(Search::MATE_SCORE - 3, result.score);
+}
+
+TEST(search_tests, wins_material) {
+    Board board;
+    Board::load_fen(board, "4k3/8/8/3q4/8/8/3R4/4K3 w - - 0 1");
+    auto search = make_search();
+    auto result = search.run(board, 2);
+    EXPECT_EQ((BoardPosition{3, 3}), result.move.next);
+}
+
+TEST(search_tests, alpha_beta_matches_minimax) {
+    MaterialScorer scorer;
+    // Positions with few captures, the quiescence search in minimax doesn't prune so it grows quickly.
+    for (const char* fen: {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                           "4k3/2r5/4p3/3p4/2N5/8/3Q4/4K3 w - - 0 1",
+                           "r3k3/1p3p2/8/3n4/4P3/2N2Q2/5P2/4K2R w - - 0 1"}) {
+        Board board;
+        Board::load_fen(board, fen);
+        auto search = make_search();
+        search.options = SearchOptions::full_width();
+        EXPECT_EQ(minimax(board, scorer, 2, 0), search.run(board, 2).score) << fen;
+    }
+}
+
+TEST(search_tests, no_moves) {
+    Board board;
+    Board::load_fen(board, "k7/8/1QK5/8/8/8/8/8 b - - 0 1");
+    auto search = make_search();
+    auto result = search.run(board, 3);
+    EXPECT_EQ(Unclassified, result.move.type);
+}
+
+TEST(search_tests, move_ordering) {
+    Board board;
+    Board::load_fen(board, "4k3/8/3q4/2P1n3/8/5N2/8/4K2R w - - 0 1");
+    auto moves = board.legal_moves(White);
+    MoveOrdering ordering;
+    std::array<int, MoveList::capacity> scores;
+
+    PackedMove best(Move({7, 7}, {6, 7}, Rook_Move));
+    ordering.score(board, moves, best, 0, scores);
+    for (size_t i = 0; i < moves.size(); i++)
+        MoveOrdering::pick(moves, scores, i);
+
+    // The best move, then pawn takes queen, knight takes knight, then the quiet moves.
+    EXPECT_EQ(best, PackedMove(moves[0]));
+    EXPECT_EQ((BoardPosition{3, 2}), moves[1].current);
+    EXPECT_EQ((BoardPosition{2, 3}), moves[1].next);
+    EXPECT_EQ((BoardPosition{5, 5}), moves[2].current);
+    EXPECT_EQ((BoardPosition{3, 4}), moves[2].next);
+    for (size_t i = 3; i < moves.size(); i++)
+        EXPECT_TRUE(MoveOrdering::is_quiet(board, moves[i]));
+
+    // A quiet move that caused a cutoff becomes the killer for its ply and goes ahead of the other quiet moves.
+    Move killer = moves[moves.size() - 1];
+    ordering.cutoff(board, killer, 3, 2);
+    moves = board.legal_moves(White);
+    ordering.score(board, moves, {}, 2, scores);
+    for (size_t i = 0; i < moves.size(); i++)
+        MoveOrdering::pick(moves, scores, i);
+    EXPECT_EQ(PackedMove(killer), PackedMove(moves[2]));
+}
+
+TEST(search_tests, cutoff_statistics) {
+    Board board;
+    Board::load_fen(board, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    auto search = make_search();
+    auto result = search.run(board, 4);
+    EXPECT_GT(result.stats.beta_cutoffs, 0);
+    EXPECT_LE(result.stats.first_move_cutoffs, result.stats.beta_cutoffs);
+    EXPECT_GT(result.stats.first_move_cutoff_rate(), 0.8);
+}
+
+TEST(search_tests, quiescence_sees_recapture) {
+    // Taking the pawn on d5 loses the queen to the pawn on e6, one ply past the horizon.
+    Board board;
+    Board::load_fen(board, "4k3/8/4p3/3p4/8/8/3Q4/4K3 w - - 0 1");
+    auto search = make_search();
+    auto result = search.run(board, 1);
+    EXPECT_FALSE(result.move.current == (BoardPosition{6, 3}) && result.move.next == (BoardPosition{3, 3}));
+    EXPECT_GT(result.stats.qnodes, 0);
+}
+
+TEST(search_tests, principal_variation) {
+    Board board;
+    Board::load_fen(board, "k7/8/2K5/8/8/8/8/7R w - - 0 1");
+    auto result = make_search().run(board, 4);
+    ASSERT_EQ(3, result.pv.size());
+    EXPECT_EQ(PackedMove(result.move), PackedMove(result.pv.front()));
+    ASSERT_EQ(1, result.lines.size());
+    EXPECT_EQ(result.score, result.lines.front().score);
+    for (auto move: result.pv) {
+        ASSERT_TRUE(board.legal(move));
+        board.move(move);
+    }
+    EXPECT_TRUE(board.checkmate());
+}
+
+TEST(search_tests, multi_pv) {
+    MaterialScorer scorer;
+    Board board;
+    Board::load_fen(board, "4k3/2r5/4p3/3p4/2N5/8/3Q4/4K3 w - - 0 1");
+    auto search = make_search();
+    search.options = SearchOptions::full_width();
+    search.options.multi_pv = 3;
+    auto result = search.run(board, 2);
+
+    // Each line's score is the exact score of its first move.
+    std::vector<int> scores;
+    for (const auto& move: board.legal_moves(White)) {
+        auto undo = board.make_move(move);
+        scores.push_back(-minimax(board, scorer, 1, 1));
+        board.unmake_move(undo);
+    }
+    std::sort(scores.rbegin(), scores.rend());
+    ASSERT_EQ(3, result.lines.size());
+    for (size_t i = 0; i < result.lines.size(); i++) {
+        EXPECT_EQ(scores[i], result.lines[i].score);
+        EXPECT_FALSE(result.lines[i].moves.empty());
+        for (size_t j = 0; j < i; j++)
+            EXPECT_NE(PackedMove(result.lines[i].moves.front()), PackedMove(result.lines[j].moves.front()));
+    }
+    EXPECT_EQ(result.score, result.lines.front().score);
+}
+
+TEST(search_tests, aspiration_windows) {
+    Board board;
+    Board::load_fen(board, perft_positions[1].fen);
+    auto search = make_search();
+    search.options = SearchOptions::full_width();
+    auto result = search.run(board, 5);
+
+    // With two lines there is no window. The window only changes how the score is found, not what it is.
+    auto without_window = make_search();
+    without_window.options = SearchOptions::full_width();
+    without_window.options.multi_pv = 2;
+    EXPECT_EQ(without_window.run(board, 5).score, result.score);
+}
+
+TEST(search_tests, selectivity) {
+    Board board;
+    Board::load_fen(board, perft_positions[1].fen);
+    auto full_width = make_search();
+    full_width.options = SearchOptions::full_width();
+    auto full = full_width.run(board, 5);
+    EXPECT_EQ(0, full.stats.null_move_tries + full.stats.reductions + full.stats.futility_prunes + full.stats.razor_prunes + full.stats.check_extensions);
+
+    auto selective = make_search().run(board, 5);
+    EXPECT_LT(selective.stats.nodes, full.stats.nodes);
+    EXPECT_GT(selective.stats.null_move_tries, 0);
+    EXPECT_GT(selective.stats.reductions, 0);
+    EXPECT_GT(selective.stats.futility_prunes, 0);
+    EXPECT_GT(selective.stats.check_extensions, 0);
+
+    // Without pieces to move a pass can be better than every real move, so the null move isn't tried.
+    Board pawns;
+    Board::load_fen(pawns, "8/8/1p6/1P6/K7/8/8/2k5 w - - 0 1");
+    auto endgame = make_search().run(pawns, 6);
+    EXPECT_EQ(0, endgame.stats.null_move_tries);
+}
+
+TEST(search_tests, lazy_smp) {
+    Board board;
+    Board::load_fen(board, "k7/8/2K5/8/8/8/8/7R w - - 0 1");
+    SmartAIPlayer player(White, 4, 1);
+    player.threads = 4;
+    // A reduced search can take a longer mate for the shortest, and which thread stores it first varies.
+    player.options = SearchOptions::full_width();
+    auto result = player.search(board);
+    EXPECT_EQ(Search::MATE_SCORE - 3, result.score);
+    player.options = {};
+
+    Board kiwipete;
+    Board::load_fen(kiwipete, perft_positions[1].fen);
+    player.depth = 3;
+    result = player.search(kiwipete);
+    bool legal = false;
+    for (const auto& move: kiwipete.legal_moves(White))
+        legal |= PackedMove(move) == PackedMove(result.move);
+    EXPECT_TRUE(legal);
+
+    // The threads share the node limit, each one may have up to 63 nodes it hasn't added to the count yet.
+    player.depth = MoveOrdering::MAX_PLY;
+    player.nodes = 5000;
+    result = player.search(kiwipete);
+    EXPECT_GE(result.stats.nodes, 5000);
+    EXPECT_LE(result.stats.nodes, 5000 + 4 * 64);
+}
+
+TEST(search_tests, stop) {
+    Board board;
+    Board::load_fen(board, perft_positions[1].fen);
+    std::atomic<bool> stop{true};
+    SearchLimits limits;
+    limits.stop = &stop;
+    auto search = make_search();
+    auto result = search.run(board, limits);
+    EXPECT_EQ(0, result.depth);
+    EXPECT_TRUE(is_legal(board, result.move));
+}
+
+TEST(search_tests, limits) {
+    Board board;
+    Board::load_fen(board, perft_positions[1].fen);
+    auto search = make_search();
+
+    SearchLimits limits;
+    limits.nodes = 5000;
+    auto result = search.run(board, limits);
+    EXPECT_LE(result.stats.nodes, 5000);
+    EXPECT_GE(result.depth, 1);
+
+    // A stopped iteration is thrown away, the move and score are the ones from the last one that finished.
+    auto shallower = make_search().run(board, result.depth);
+    EXPECT_EQ(shallower.score, result.score);
+
+    limits = {};
+    limits.deadline = TimeManager::Clock::now();
+    result = search.run(board, limits);
+    EXPECT_EQ(0, result.depth);
+
+    limits = {};
+    limits.deadline = TimeManager::Clock::now() + std::chrono::milliseconds(100);
+    auto start = TimeManager::Clock::now();
+    search.run(board, limits);
+    EXPECT_LT(TimeManager::Clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(search_tests, time_manager) {
+    using namespace std::chrono_literals;
+    TimeManager time(60s, 1s);
+    EXPECT_EQ(2750ms, time.optimum);
+    EXPECT_LE(time.optimum, time.maximum);
+    EXPECT_LE(time.maximum, 21s);
+
+    EXPECT_FALSE(time.keep_deepening(0ms, 0, 1));
+    EXPECT_TRUE(time.keep_deepening(1000ms, 0, 30));
+    EXPECT_FALSE(time.keep_deepening(2000ms, 0, 30));
+    // An unstable best move or a busy position gets more time.
+    EXPECT_TRUE(time.keep_deepening(2000ms, 2, 30));
+    EXPECT_TRUE(time.keep_deepening(1600ms, 0, 45));
+
+    Board board;
+    Board::load_fen(board, perft_positions[1].fen);
+    TimeManager short_time(3s);
+    SearchLimits limits;
+    limits.time = &short_time;
+    auto start = TimeManager::Clock::now();
+    auto result = make_search().run(board, limits);
+    EXPECT_LE(TimeManager::Clock::now() - start, short_time.maximum + 100ms);
+    EXPECT_TRUE(is_legal(board, result.move));
+}
+
+TEST(search_tests, autonomous_player_shutdown) {
+    auto player = std::make_shared<SmartAIPlayer>(Black, Search::MAX_PLY, 1);
+    Board board;
+    Board::setup(board);
+    Move king_pawn{{6, 4}, {4, 4}};
+    board.move(board.classify_move(king_pawn));
+
+    auto start = TimeManager::Clock::now();
+    {
+        AutonomousPlayer autonomous(player);
+        autonomous.start(board);
+        EXPECT_TRUE(autonomous.is_running());
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        autonomous.stop();
+        while (!autonomous.is_done())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        EXPECT_TRUE(is_legal(board, autonomous.get_move()));
+
+        // Closing in the middle of a search doesn't wait for it to finish.
+        autonomous.start(board);
+    }
+    EXPECT_LT(TimeManager::Clock::now() - start, std::chrono::seconds(2));
+}
+
+TEST(search_tests, ponder) {
+    using namespace std::chrono_literals;
+    Board board;
+    Board::load_fen(board, perft_positions[1].fen);
+    TimeManager time(3s);
+    std::atomic<bool> pondering{true}, finished{false};
+    SearchLimits limits;
+    limits.time = &time;
+    limits.ponder = &pondering;
+
+    // The clock doesn't run until the expected move is played.
+    auto search = make_search();
+    std::thread thread([&]() {
+        search.run(board, limits);
+        finished = true;
+    });
+    std::this_thread::sleep_for(time.maximum + 100ms);
+    EXPECT_FALSE(finished);
+    auto hit = TimeManager::Clock::now();
+    pondering = false;
+    thread.join();
+    EXPECT_LE(TimeManager::Clock::now() - hit, time.maximum + 100ms);
+}
+
+static Move wait_for_move(AutonomousPlayer& autonomous) {
+    while (!autonomous.is_done())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return autonomous.get_move();
+}
+
+TEST(search_tests, autonomous_player_ponder) {
+    auto player = std::make_shared<SmartAIPlayer>(Black, 3, 1);
+    AutonomousPlayer autonomous(player);
+    Board board;
+    Board::setup(board);
+    Move king_pawn{{6, 4}, {4, 4}};
+    board.move(board.classify_move(king_pawn));
+
+    autonomous.start(board);
+    auto move = wait_for_move(autonomous);
+    ASSERT_TRUE(is_legal(board, move));
+    board.make_move(move);
+    auto reply = player->expected_reply(board);
+    ASSERT_FALSE(PackedMove(reply).empty());
+    EXPECT_TRUE(autonomous.is_pondering());
+
+    // The expected reply: the move comes from the search that was pondering.
+    Board hit = board;
+    hit.make_move(reply);
+    autonomous.start(hit);
+    move = wait_for_move(autonomous);
+    EXPECT_TRUE(is_legal(hit, move));
+    hit.make_move(move);
+
+    // Any other reply: the ponder search is dropped and the move is searched from scratch.
+    Board miss = hit;
+    auto expected = PackedMove(player->expected_reply(hit));
+    for (const auto& other: hit.legal_moves(White)) {
+        if (PackedMove(other) != expected) {
+            miss.make_move(other);
+            break;
+        }
+    }
+    autonomous.start(miss);
+    move = wait_for_move(autonomous);
+    EXPECT_TRUE(is_legal(miss, move));
+}
+
+/*
+ * Counts the searches that start from scratch, pondering goes through ponder instead.
+ */
+struct CountingPlayer: SmartAIPlayer {
+    using SmartAIPlayer::SmartAIPlayer;
+    using SmartAIPlayer::move;
+
+    [[nodiscard]] Move move(const Board& board, const std::atomic<bool>& stop) const override {
+        searches++;
+        return SmartAIPlayer::move(board, stop);
+    }
+
+    mutable std::atomic<int> searches{0};
+};
+
+TEST(search_tests, autonomous_player_stop_while_pondering) {
+    auto player = std::make_shared<CountingPlayer>(Black, 3, 1);
+    AutonomousPlayer autonomous(player);
+    Board board;
+    Board::setup(board);
+    Move king_pawn{{6, 4}, {4, 4}};
+    board.move(board.classify_move(king_pawn));
+
+    autonomous.start(board);
+    auto move = wait_for_move(autonomous);
+    ASSERT_TRUE(is_legal(board, move));
+    board.make_move(move);
+    auto reply = player->expected_reply(board);
+    ASSERT_FALSE(PackedMove(reply).empty());
+    while (!autonomous.is_pondering())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(1, player->searches);
+
+    // The expected reply after a stop: the cut short ponder search is dropped for a new one.
+    autonomous.stop();
+    EXPECT_FALSE(autonomous.is_pondering());
+    board.make_move(reply);
+    autonomous.start(board);
+    move = wait_for_move(autonomous);
+    EXPECT_TRUE(is_legal(board, move));
+    EXPECT_EQ(2, player->searches);
+}
@@ -0,0 +1,68 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "gtest/gtest.h"
+
+#include "pure_states/see.h"
+
+static int see(const char* fen, BoardPosition from, BoardPosition to) {
+    Board board;
+    Board::load_fen(board, fen);
+    auto moves = board.legal_moves(board.side_to_move());
+    for (const auto& move: moves) {
+        if (move.current == from && move.next == to && (move.type != Pawn_Promotion || move.promotion == Queen))
+            return static_exchange(board, move);
+    }
+    ADD_FAILURE() << "no move from " << from.row << "," << from.column << " to " << to.row << "," << to.column;
+    return 0;
+}
+
+TEST(see_tests, undefended_piece) {
+    // Rook takes an undefended pawn.
+    EXPECT_EQ(1, see("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", {7, 4}, {3, 4}));
+}
+
+TEST(see_tests, defended_piece) {
+    // Knight takes a pawn defended by a pawn and loses the knight.
+    EXPECT_EQ(1 - 5, see("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", {5, 3}, {3, 4}));
+    // Queen takes a rook defended by a pawn.
+    EXPECT_EQ(10 - 25, see("4k3/8/2p5/1r6/8/8/8/1Q2K3 w - - 0 1", {7, 1}, {3, 1}));
+}
+
+TEST(see_tests, attacker_can_stop) {
+    // Pawn takes a knight defended by a rook, which recaptures.
+    EXPECT_EQ(5 - 1, see("4k3/8/3r4/3n4/4P3/8/8/4K3 w - - 0 1", {4, 4}, {3, 3}));
+    // Rook takes a pawn defended by a queen that is in turn attacked by a pawn: the queen won't recapture.
+    EXPECT_EQ(1, see("4k3/8/2q5/3p4/4P3/3R4/8/4K3 w - - 0 1", {5, 3}, {3, 3}));
+}
+
+TEST(see_tests, x_rays) {
+    // Two rooks doubled against a pawn defended by one rook.
+    EXPECT_EQ(1, see("3r2k1/8/8/3p4/8/8/3R4/3RK3 w - - 0 1", {6, 3}, {3, 3}));
+    // The same with the defender doubled too, taking loses a rook for a rook and a pawn.
+    EXPECT_EQ(1 - 10 + 10 - 10, see("3r2k1/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1", {6, 3}, {3, 3}));
+    // A queen behind a bishop makes taking a pawn defended by a knight safe.
+    EXPECT_EQ(1, see("6k1/8/3n4/8/4p3/5B2/6Q1/6K1 w - - 0 1", {5, 5}, {4, 4}));
+}
+
+TEST(see_tests, king_takes_only_undefended) {
+    // The king recaptures the bishop.
+    EXPECT_EQ(1 - 10 + 5, see("4k3/8/8/8/1b6/8/3p4/3RK3 w - - 0 1", {7, 3}, {6, 3}));
+    // The rook behind the pawn stops it.
+    EXPECT_EQ(1 - 10, see("3rk3/8/8/8/1b6/8/3p4/3RK3 w - - 0 1", {7, 3}, {6, 3}));
+}
+
+TEST(see_tests, exchange_sequence) {
+    Board board;
+    Board::load_fen(board, "3r2k1/3r4/8/3p4/8/4N3/3R4/3RK3 w - - 0 1");
+    auto pieces = exchange_sequence(board, {3, 3});
+    std::vector<Pieces> types;
+    for (const auto& piece: pieces)
+        types.push_back(piece.type);
+    // The pawn, knight, rook, rook, rook, rook: the rooks behind the first ones join in as x-rays.
+    EXPECT_EQ((std::vector<Pieces>{Pawn, Knight, Rook, Rook, Rook, Rook}), types);
+    EXPECT_EQ(Black, pieces[0].side);
+    EXPECT_EQ(White, pieces[1].side);
+    EXPECT_EQ(Black, pieces[2].side);
+}
@@ -8,6 +8,8 @@
 
 #include "scorers/control_scorer.h"
 #include "scorers/development_scorer.h"
+#include "scorers/material_scorer.h"
+#include "scorers/piece_square_scorer.h"
 
 #include <vector>
 
@@ -38,10 +40,8 @@ TEST(scorer_tests, control_scorer) {
     Move move4{{5, 2}, {3, 3}, Knight_Move};
     b1.move(move4);
 
-    auto white = b1.get_pieces(White);
-    auto black = b1.get_pieces(Black);
 
-    EXPECT_EQ(20, ControlScorer::score_take(b1, {3, 3}, White, white, black));
+    EXPECT_EQ(20, ControlScorer::score_take(b1, {3, 3}, White));
 
     EXPECT_EQ(0, scorer.score(b1, White));
 }
@@ -111,7 +111,7 @@ TEST(scorer_tests, control_scorer_3) {
 
     ControlScorer scorer;
 
-    EXPECT_EQ(-4, ControlScorer::score_take(b1, {3, 3}, Black, b1.get_pieces(White), b1.get_pieces(Black)));
+    EXPECT_EQ(-4, ControlScorer::score_take(b1, {3, 3}, Black));
     EXPECT_EQ(-4, scorer.score(b1, Black));
 }
 
@@ -139,30 +139,57 @@ TEST(smart_ai_tests, score_position_control) {
     b1.set_piece_at({4, 3}, {Pawn, Black});
     b1.set_piece_at({4, 0}, {Rook, Black});
 
-    auto white = b1.get_pieces(White);
-    auto black = b1.get_pieces(Black);
 
-    EXPECT_EQ(9, ControlScorer::score_take(b1, {4, 3}, Black, white, black));
-    EXPECT_EQ(-9, ControlScorer::score_take(b1, {4, 3}, White, white, black));
+    EXPECT_EQ(9, ControlScorer::score_take(b1, {4, 3}, Black));
+    EXPECT_EQ(-9, ControlScorer::score_take(b1, {4, 3}, White));
 
     b1.set_piece_at({5, 4}, {Pawn, White});
 
-    white = b1.get_pieces(White);
-    black = b1.get_pieces(Black);
 
-    EXPECT_EQ(-10, ControlScorer::score_take(b1, {4, 3}, Black, white, black));
-    EXPECT_EQ(10, ControlScorer::score_take(b1, {4, 3}, White, white, black));
+    EXPECT_EQ(-10, ControlScorer::score_take(b1, {4, 3}, Black));
+    EXPECT_EQ(10, ControlScorer::score_take(b1, {4, 3}, White));
 
     Board b2;
 
     b2.set_piece_at({0, 0}, {Queen, White});
     b2.set_piece_at({0, 4}, {Pawn, Black});
 
-    white = b2.get_pieces(White);
-    black = b2.get_pieces(Black);
 
-    EXPECT_EQ(-1, ControlScorer::score_take(b2, {0, 4}, Black, white, black));
-    EXPECT_EQ(1, ControlScorer::score_take(b2, {0, 4}, White, white, black));
+    EXPECT_EQ(-1, ControlScorer::score_take(b2, {0, 4}, Black));
+    EXPECT_EQ(1, ControlScorer::score_take(b2, {0, 4}, White));
+}
+
+TEST(scorer_tests, material_scorer) {
+    MaterialScorer scorer;
+    Board board;
+    Board::setup(board);
+    EXPECT_EQ(0, scorer.score(board, White));
+
+    Board queen;
+    Board::load_fen(queen, "4k3/8/8/8/8/8/8/3QK3 w - - 0 1");
+    EXPECT_EQ(25, scorer.score(queen, White));
+    EXPECT_EQ(-25, scorer.score(queen, Black));
+}
+
+TEST(scorer_tests, piece_square_scorer) {
+    PieceSquareScorer scorer;
+    Board board;
+    Board::setup(board);
+    EXPECT_EQ(0, scorer.score(board, White));
+
+    // With nothing left to attack it, a king in the center is worth 70 hundredths over one on its back rank.
+    Board kings;
+    Board::load_fen(kings, "4k3/8/8/8/4K3/8/8/8 w - - 0 1");
+    EXPECT_EQ(0, kings.totals.phase);
+    EXPECT_EQ(7, scorer.score(kings, White));
+    EXPECT_EQ(-7, scorer.score(kings, Black));
+
+    // The queens are a third of the phase, so a third of the score comes from the middlegame table, where that king is at -40.
+    Board queens;
+    Board::load_fen(queens, "3qk3/8/8/8/4K3/8/8/3Q4 w - - 0 1");
+    EXPECT_EQ(8, queens.totals.phase);
+    EXPECT_EQ(33, queens.totals.positional(White));
+    EXPECT_EQ(3, scorer.score(queens, White));
 }
 
 TEST(smart_ai_tests, compute_composite_score) {
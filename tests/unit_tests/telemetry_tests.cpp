@@ -0,0 +1,130 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "search/telemetry.h"
+#include "players/smart_ai_player.h"
+
+static const char* KIWIPETE = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+
+TEST(telemetry_tests, search_counters) {
+    Board board;
+    Board::load_fen(board, KIWIPETE);
+    SmartAIPlayer player(White, 4, 1);
+    player.time_scorers = true;
+    auto result = player.search(board);
+    const auto& stats = result.stats;
+
+    ASSERT_EQ(4, result.iterations.size());
+    uint64_t nodes = 0;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(i + 1, result.iterations[i].depth);
+        EXPECT_TRUE(result.iterations[i].finished);
+        nodes += result.iterations[i].nodes;
+    }
+    EXPECT_EQ(stats.nodes, nodes);
+    EXPECT_EQ(result.score, result.iterations.back().score);
+    EXPECT_GT(result.time.count(), 0);
+    EXPECT_GT(result.nodes_per_second(), 0);
+    EXPECT_DOUBLE_EQ((double)result.iterations[3].nodes / result.iterations[2].nodes, result.branching_factor());
+
+    EXPECT_GT(stats.table_probes, 0);
+    EXPECT_GE(stats.table_probes, stats.table_hits);
+    EXPECT_GE(stats.table_hits, stats.table_cutoffs);
+    EXPECT_EQ(stats.beta_cutoffs, std::accumulate(stats.cutoff_moves.begin(), stats.cutoff_moves.end(), uint64_t{0}));
+    EXPECT_EQ(stats.first_move_cutoffs, stats.cutoff_moves[0]);
+
+    ASSERT_EQ(4, result.scorer_times.size());
+    EXPECT_EQ("center", result.scorer_times[0].name);
+    for (const auto& scorer: result.scorer_times) {
+        EXPECT_GT(scorer.calls, 0);
+        EXPECT_GT(scorer.time.count(), 0);
+    }
+
+    // Only this search's share, and none while the timing is off.
+    auto again = player.search(board);
+    EXPECT_EQ(player.scorer_times()[2].calls, result.scorer_times[2].calls + again.scorer_times[2].calls);
+    player.time_scorers = false;
+    EXPECT_TRUE(player.search(board).scorer_times.empty());
+    EXPECT_EQ(player.scorer_times()[2].calls, result.scorer_times[2].calls + again.scorer_times[2].calls);
+}
+
+TEST(telemetry_tests, unfinished_iteration) {
+    Board board;
+    Board::load_fen(board, KIWIPETE);
+    Search search(std::make_shared<MaterialScorer>(), std::make_shared<TranspositionTable>(1));
+    SearchLimits limits;
+    limits.nodes = 3000;
+    auto result = search.run(board, limits);
+    ASSERT_FALSE(result.iterations.empty());
+    EXPECT_FALSE(result.iterations.back().finished);
+    EXPECT_EQ(result.depth, result.iterations.back().depth - 1);
+}
+
+TEST(telemetry_tests, json_lines) {
+    Board board;
+    Board::load_fen(board, KIWIPETE);
+    auto path = (std::filesystem::temp_directory_path() / "telemetry_tests.jsonl").string();
+    std::filesystem::remove(path);
+
+    SmartAIPlayer player(White, 2, 1);
+    player.telemetry = std::make_shared<TelemetryLog>();
+    ASSERT_TRUE(player.telemetry->open(path));
+    auto result = player.search(board);
+    auto again = player.search(board);
+
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) {
+        EXPECT_EQ('{', line.front());
+        EXPECT_EQ('}', line.back());
+        lines.push_back(line);
+    }
+    ASSERT_EQ(2, lines.size());
+    EXPECT_EQ(telemetry_json(result), lines[0]);
+    EXPECT_EQ(telemetry_json(again), lines[1]);
+
+    auto json = telemetry_json(result);
+    EXPECT_NE(std::string::npos, json.find("\"nodes\":" + std::to_string(result.stats.nodes) + ","));
+    EXPECT_NE(std::string::npos, json.find("\"iterations\":[{\"depth\":1,"));
+    EXPECT_NE(std::string::npos, json.find("{\"name\":\"material\",\"calls\":"));
+    EXPECT_EQ(0, json.find("{\"move\":\""));
+    std::filesystem::remove(path);
+}
+
+/*
+ * The helper threads' nodes are in the logged line as well as in the result.
+ */
+TEST(telemetry_tests, helper_threads) {
+    Board board;
+    Board::load_fen(board, KIWIPETE);
+    auto path = (std::filesystem::temp_directory_path() / "telemetry_tests_threads.jsonl").string();
+    std::filesystem::remove(path);
+
+    SmartAIPlayer player(White, 4, 1);
+    player.threads = 2;
+    player.telemetry = std::make_shared<TelemetryLog>();
+    ASSERT_TRUE(player.telemetry->open(path));
+    auto result = player.search(board);
+
+    uint64_t main_nodes = 0;
+    for (const auto& iteration: result.iterations)
+        main_nodes += iteration.nodes;
+    EXPECT_GT(result.stats.nodes, main_nodes);
+
+    std::ifstream in(path);
+    std::string line;
+    ASSERT_TRUE(std::getline(in, line));
+    EXPECT_NE(std::string::npos, line.find("\"nodes\":" + std::to_string(result.stats.nodes) + ","));
+    EXPECT_EQ(telemetry_json(result), line);
+    in.close();
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,79 @@
+//
+// Created by Chris Luttio on 1/15/22.
+//
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "search/transposition_table.h"
+
+TEST(transposition_table_tests, store_and_probe) {
+    TranspositionTable table(1);
+    EXPECT_EQ(1024 * 1024 / 16, table.size());
+
+    TranspositionEntry entry;
+    EXPECT_FALSE(table.probe(0x1234, entry));
+
+    PackedMove move(Move({6, 4}, {4, 4}, Pawn_DoubleMove));
+    table.store(0x1234, 5, LowerBound, -100000, move);
+    ASSERT_TRUE(table.probe(0x1234, entry));
+    EXPECT_EQ(5, entry.depth);
+    EXPECT_EQ(LowerBound, entry.bound);
+    EXPECT_EQ(-100000, entry.score);
+    EXPECT_EQ(move, entry.move);
+
+    // A key in the same cluster isn't mistaken for it.
+    EXPECT_FALSE(table.probe(0x1234 + (uint64_t{1} << 40), entry));
+}
+
+TEST(transposition_table_tests, depth_preferred_replacement) {
+    TranspositionTable table(1);
+    TranspositionEntry entry;
+    PackedMove move(Move({7, 6}, {5, 5}, Knight_Move));
+
+    table.store(42, 6, LowerBound, 10, move);
+    table.store(42, 3, UpperBound, 20, {});
+    ASSERT_TRUE(table.probe(42, entry));
+    EXPECT_EQ(6, entry.depth);
+    EXPECT_EQ(10, entry.score);
+
+    // A deeper result replaces it, and keeps the old best move if it has none.
+    table.store(42, 7, UpperBound, 30, {});
+    ASSERT_TRUE(table.probe(42, entry));
+    EXPECT_EQ(7, entry.depth);
+    EXPECT_EQ(move, entry.move);
+
+    // Filling the cluster pushes out the shallowest entry.
+    uint64_t stride = table.size() / TranspositionTable::cluster_size;
+    for (int i = 1; i <= TranspositionTable::cluster_size; i++)
+        table.store(42 + stride * i, 1 + i, ExactBound, i, {});
+    EXPECT_TRUE(table.probe(42, entry));
+    EXPECT_FALSE(table.probe(42 + stride, entry));
+
+    table.clear();
+    EXPECT_FALSE(table.probe(42, entry));
+}
+
+TEST(transposition_table_tests, shared_between_threads) {
+    TranspositionTable table(1);
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (uint64_t i = 0; i < 200000; i++) {
+                // Few keys so the threads keep writing over each other's entries.
+                uint64_t key = ((i * 7 + t) % 512) * 0x9e3779b97f4a7c15;
+                table.store(key, (int)(key % 50), ExactBound, (int)(key >> 40), {});
+                TranspositionEntry entry;
+                if (table.probe(key, entry) && (entry.score != (int)(key >> 40) || entry.depth != (int)(key % 50)))
+                    mismatches++;
+            }
+        });
+    }
+    for (auto& thread: threads)
+        thread.join();
+    EXPECT_EQ(0, mismatches);
+}
@@ -0,0 +1,45 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "pure_states/bitbases.h"
+
+using namespace std;
+
+/*
+ * bitbases <directory>
+ *
+ * Generates the endgame bitbases into the directory, where the game loads them from instead of generating them on its first run.
+ */
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        cerr << "Usage: bitbases <directory>\n";
+        return 2;
+    }
+    error_code error;
+    filesystem::create_directories(argv[1], error);
+    auto start = chrono::steady_clock::now();
+    Bitbases bitbases;
+    bitbases.generate();
+    for (auto ending: {Bitbases::KPK, Bitbases::KRK, Bitbases::KQK, Bitbases::KBNK}) {
+        const auto& bitbase = bitbases.endings[ending];
+        auto path = (filesystem::path(argv[1]) / (string(Bitbases::NAMES[ending]) + ".bitbase")).string();
+        if (!bitbase.save(path)) {
+            cerr << "Error: can't write " << path << ".\n";
+            return 1;
+        }
+        size_t wins = 0;
+        for (auto word: bitbase.wins)
+            wins += count_squares(word);
+        cout << Bitbases::NAMES[ending] << ": " << bitbase.size() << " positions, " << wins << " won\n";
+    }
+    auto seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Generated in " << seconds << "s\n";
+    return 0;
+}
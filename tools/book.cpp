@@ -0,0 +1,83 @@
+//
+// Created by Chris Luttio on 1/17/22.
+//
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "search/opening_book.h"
+
+using namespace std;
+
+/*
+ * book <lines.txt> <book.bin>
+ *
+ * Builds an opening book from lines of play, one line per row, each move in coordinate notation (e2e4, e7e8q), from the starting position.
+ * Every move in a line is added to the book for the position it was played from, a move's weight is how many lines play it.
+ * Rows starting with # are comments.
+ */
+
+static bool parse_move(const Board& board, const string& text, Move& move) {
+    if (text.size() < 4 || text[0] < 'a' || text[0] > 'h' || text[2] < 'a' || text[2] > 'h'
+        || text[1] < '1' || text[1] > '8' || text[3] < '1' || text[3] > '8')
+        return false;
+    move = Move({'8' - text[1], text[0] - 'a'}, {'8' - text[3], text[2] - 'a'});
+    if (text.size() > 4) {
+        switch (text[4]) {
+            case 'n': move.promotion = Knight; break;
+            case 'b': move.promotion = Bishop; break;
+            case 'r': move.promotion = Rook; break;
+            default: move.promotion = Queen; break;
+        }
+    }
+    return board.legal(move);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        cerr << "Usage: book <lines.txt> <book.bin>\n";
+        return 2;
+    }
+    ifstream in(argv[1]);
+    if (!in) {
+        cerr << "Error: can't read " << argv[1] << ".\n";
+        return 1;
+    }
+
+    map<pair<uint64_t, uint16_t>, int> weights;
+    string row;
+    int number = 0, lines = 0;
+    while (getline(in, row)) {
+        number++;
+        if (row.empty() || row[0] == '#')
+            continue;
+        Board board;
+        Board::setup(board);
+        istringstream moves(row);
+        string text;
+        while (moves >> text) {
+            Move move;
+            if (!parse_move(board, text, move)) {
+                cerr << "Error: " << argv[1] << ":" << number << ": " << text << " isn't a legal move.\n";
+                return 1;
+            }
+            weights[{OpeningBook::key(board), OpeningBook::encode(move)}]++;
+            board.move(move);
+        }
+        lines++;
+    }
+
+    vector<BookEntry> entries;
+    for (const auto& [position, weight]: weights)
+        entries.push_back({position.first, position.second, (uint16_t)min(weight, 0xffff), 0});
+    if (!OpeningBook::write(argv[2], entries)) {
+        cerr << "Error: can't write " << argv[2] << ".\n";
+        return 1;
+    }
+    cout << lines << " lines, " << entries.size() << " entries\n";
+    return 0;
+}
@@ -0,0 +1,138 @@
+//
+// Created by Chris Luttio on 1/14/22.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "pure_states/perft.h"
+
+using namespace std;
+
+/*
+ * perft [depth] [--divide] [--fen <fen>] [--threads <n>] [--hash <mb>] [--scaling]
+ *
+ * Without a FEN every reference position is run and checked against its published count.
+ * With --divide the count under each root move is printed as well, to narrow down where two generators disagree.
+ * With --threads or --hash the count is split across threads sharing a hash table of subtree counts.
+ * With --scaling each position is run with 1 to n threads and the speedup and efficiency against one thread are printed.
+ */
+
+struct Options {
+    int depth = 4;
+    bool divide = false;
+    int threads = 1;
+    size_t hash_mb = 0;
+    bool scaling = false;
+};
+
+static string square_name(BoardPosition position) {
+    return {char('a' + position.column), char('8' - position.row)};
+}
+
+static string move_name(const Move& move) {
+    string name = square_name(move.current) + square_name(move.next);
+    if (move.type == Pawn_Promotion)
+        name += "?rbnq"[move.promotion - Pawn];
+    return name;
+}
+
+/*
+ * Returns the number of leaf nodes at options.depth, printing each root move's count first when dividing.
+ * The count is checked against the expected one by run.
+ */
+static uint64_t count(Board& board, const Options& options, int threads, PerftTable* table) {
+    if (options.divide) {
+        uint64_t nodes = 0;
+        for (const auto& [move, count]: perft_divide(board, options.depth)) {
+            cout << "  " << move_name(move) << ": " << count << "\n";
+            nodes += count;
+        }
+        return nodes;
+    }
+    if (!table)
+        return perft(board, options.depth);
+    return perft_parallel(board, options.depth, threads, *table);
+}
+
+/*
+ * Counts the position with each number of threads asked for and prints the counts and speeds.
+ * Returns false if the FEN can't be read or a count differs from expected, an expected count of 0 isn't checked.
+ */
+static bool run(const string& name, const string& fen, const Options& options, uint64_t expected) {
+    Board board;
+    if (!Board::load_fen(board, fen)) {
+        cerr << "Error: can't read FEN \"" << fen << "\".\n";
+        return false;
+    }
+
+    bool hashed = !options.divide && (options.threads > 1 || options.hash_mb > 0 || options.scaling);
+    bool correct = true;
+    double single_thread_seconds = 0;
+    int first = options.scaling ? 1 : options.threads;
+    for (int threads = first; threads <= options.threads; threads++) {
+        unique_ptr<PerftTable> table;
+        if (hashed)
+            table = make_unique<PerftTable>(options.hash_mb > 0 ? options.hash_mb : 64);
+        auto start = chrono::steady_clock::now();
+        uint64_t nodes = count(board, options, threads, table.get());
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (threads == 1)
+            single_thread_seconds = seconds;
+
+        bool matches = expected == 0 || nodes == expected;
+        cout << name << " depth " << options.depth << ": " << nodes << " nodes in " << seconds << "s, "
+             << (uint64_t)(seconds > 0 ? nodes / seconds : 0) << " nodes/s";
+        if (options.threads > 1 || options.scaling)
+            cout << ", " << threads << " threads";
+        if (options.scaling && seconds > 0) {
+            double speedup = single_thread_seconds / seconds;
+            cout << ", speedup " << speedup << ", efficiency " << speedup / threads;
+        }
+        if (!matches)
+            cout << " (expected " << expected << ")";
+        cout << "\n";
+        correct &= matches;
+    }
+    return correct;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    string fen;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--divide") == 0) {
+            options.divide = true;
+        } else if (strcmp(argv[i], "--scaling") == 0) {
+            options.scaling = true;
+        } else if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            options.hash_mb = max(1, atoi(argv[++i]));
+        } else if (isdigit(argv[i][0])) {
+            options.depth = atoi(argv[i]);
+        } else {
+            cerr << "Usage: perft [depth] [--divide] [--fen <fen>] [--threads <n>] [--hash <mb>] [--scaling]\n";
+            return 2;
+        }
+    }
+
+    if (!fen.empty())
+        return run("fen", fen, options, 0) ? 0 : 1;
+
+    bool correct = true;
+    for (const auto& position: perft_positions) {
+        int depth = options.depth;
+        uint64_t expected = depth >= 1 && depth <= (int)position.nodes.size() ? position.nodes[depth - 1] : 0;
+        correct &= run(position.name, position.fen, options, expected);
+    }
+    return correct ? 0 : 1;
+}